@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AimCameraBlendComponent.h"
+#include "Camera/CameraComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+
+UAimCameraBlendComponent::UAimCameraBlendComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// Before the boom updates the camera transform
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	BlendAlpha = 0.1f;
+	Tolerance = 0.05f;
+
+	CameraBoom = NULL;
+	Camera = NULL;
+}
+
+void UAimCameraBlendComponent::SetCamera(USpringArmComponent* InCameraBoom, UCameraComponent* InCamera)
+{
+	CameraBoom = InCameraBoom;
+	Camera = InCamera;
+}
+
+void UAimCameraBlendComponent::BlendTo(const FAimCameraPose& Pose)
+{
+	TargetPose = Pose;
+	SetComponentTickEnabled(CameraBoom != NULL && Camera != NULL);
+}
+
+void UAimCameraBlendComponent::SnapTo(const FAimCameraPose& Pose)
+{
+	TargetPose = Pose;
+	ApplyPose(Pose);
+	SetComponentTickEnabled(false);
+}
+
+void UAimCameraBlendComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (CameraBoom == NULL || Camera == NULL)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	// BlendAlpha is tuned per 60 Hz frame, scale the remaining fraction by elapsed frames
+	const float Alpha = 1.0f - FMath::Pow(1.0f - BlendAlpha, DeltaTime * 60.0f);
+
+	FAimCameraPose Pose;
+	Pose.TargetArmLength = FMath::Lerp(CameraBoom->TargetArmLength, TargetPose.TargetArmLength, Alpha);
+	Pose.FieldOfView = FMath::Lerp(Camera->FieldOfView, TargetPose.FieldOfView, Alpha);
+	Pose.SocketOffsetY = FMath::Lerp(CameraBoom->SocketOffset.Y, TargetPose.SocketOffsetY, Alpha);
+
+	const bool bConverged = FMath::IsNearlyEqual(Pose.TargetArmLength, TargetPose.TargetArmLength, Tolerance)
+		&& FMath::IsNearlyEqual(Pose.FieldOfView, TargetPose.FieldOfView, Tolerance)
+		&& FMath::IsNearlyEqual(Pose.SocketOffsetY, TargetPose.SocketOffsetY, Tolerance);
+
+	if (bConverged)
+	{
+		ApplyPose(TargetPose);
+		SetComponentTickEnabled(false);
+	}
+	else
+	{
+		ApplyPose(Pose);
+	}
+}
+
+void UAimCameraBlendComponent::ApplyPose(const FAimCameraPose& Pose)
+{
+	if (CameraBoom != NULL && Camera != NULL)
+	{
+		CameraBoom->TargetArmLength = Pose.TargetArmLength;
+		CameraBoom->SocketOffset.Y = Pose.SocketOffsetY;
+		Camera->SetFieldOfView(Pose.FieldOfView);
+	}
+}
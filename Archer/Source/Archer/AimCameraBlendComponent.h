@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AimCameraBlendComponent.generated.h"
+
+class USpringArmComponent;
+class UCameraComponent;
+
+/** Camera boom and camera settings the aim blend moves between */
+USTRUCT(BlueprintType)
+struct FAimCameraPose
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+	float TargetArmLength = 300.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+	float FieldOfView = 90.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+	float SocketOffsetY = 0.0f;
+};
+
+/**
+ * Smoothly moves a camera boom and camera towards a pose when switching in and out of aim mode.
+ * Ticks only while a blend is in progress and smooths by delta time, so the zoom takes the same time at any frame rate.
+ */
+UCLASS(ClassGroup = Camera, meta = (BlueprintSpawnableComponent))
+class ARCHER_API UAimCameraBlendComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UAimCameraBlendComponent();
+
+	/** Fraction of the remaining distance covered per 1/60 s */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float BlendAlpha;
+
+	/** Blend stops and snaps to the target once every value is this close */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+	float Tolerance;
+
+	/** Set the boom and camera to drive */
+	void SetCamera(USpringArmComponent* InCameraBoom, UCameraComponent* InCamera);
+
+	/** Start blending towards Pose, the component ticks until it gets there */
+	UFUNCTION(BlueprintCallable, Category = Camera)
+	void BlendTo(const FAimCameraPose& Pose);
+
+	/** Jump to Pose and stop any blend in progress */
+	UFUNCTION(BlueprintCallable, Category = Camera)
+	void SnapTo(const FAimCameraPose& Pose);
+
+	UFUNCTION(BlueprintPure, Category = Camera)
+	bool IsBlending() const { return IsComponentTickEnabled(); }
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	UPROPERTY(Transient)
+	USpringArmComponent* CameraBoom;
+
+	UPROPERTY(Transient)
+	UCameraComponent* Camera;
+
+	FAimCameraPose TargetPose;
+
+	void ApplyPose(const FAimCameraPose& Pose);
+};
@@ -9,5 +9,7 @@ public class Archer : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "RenderCore", "SignificanceManager", "ReplicationGraph", "AIModule" });
 	}
 }
@@ -4,4 +4,42 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Archer, "Archer" );
- 
\ No newline at end of file
+
+DEFINE_LOG_CATEGORY(LogArcher);
+
+DEFINE_STAT(STAT_ArcherShoot);
+DEFINE_STAT(STAT_ArcherLaunchProjectile);
+DEFINE_STAT(STAT_ArcherAim);
+DEFINE_STAT(STAT_ArcherStopAiming);
+DEFINE_STAT(STAT_ArcherPlayMontageAnimation);
+DEFINE_STAT(STAT_ArcherMoveInput);
+DEFINE_STAT(STAT_ArcherEquipWeapon);
+DEFINE_STAT(STAT_ProjectileOnHit);
+DEFINE_STAT(STAT_ProjectileRewindSweep);
+DEFINE_STAT(STAT_ArrowPoolAcquire);
+DEFINE_STAT(STAT_ArrowPoolRelease);
+DEFINE_STAT(STAT_ArrowLifetimeTick);
+DEFINE_STAT(STAT_ArrowSimulationIntegrate);
+DEFINE_STAT(STAT_ArrowSimulationTraces);
+DEFINE_STAT(STAT_ArrowInstanceCommit);
+DEFINE_STAT(STAT_ArrowImpulseFlush);
+DEFINE_STAT(STAT_ArcherAIThink);
+DEFINE_STAT(STAT_ArcherSpatialIndexUpdate);
+DEFINE_STAT(STAT_ArcherSpatialIndexQuery);
+DEFINE_STAT(STAT_ArcherImpactDispatch);
+
+DEFINE_STAT(STAT_ArrowImpulsesMerged);
+DEFINE_STAT(STAT_ArrowImpulseBodies);
+DEFINE_STAT(STAT_ArcherAIBotsThought);
+DEFINE_STAT(STAT_ArcherImpactEvents);
+DEFINE_STAT(STAT_ArcherImpactVictims);
+
+DEFINE_STAT(STAT_LiveArrows);
+DEFINE_STAT(STAT_PooledArrows);
+DEFINE_STAT(STAT_SimulatedArrows);
+DEFINE_STAT(STAT_ArrowInstances);
+DEFINE_STAT(STAT_StuckArrows);
+DEFINE_STAT(STAT_IndexedArchers);
+
+DEFINE_STAT(STAT_ArrowSimulationMemory);
+DEFINE_STAT(STAT_ArrowInstanceMemory);
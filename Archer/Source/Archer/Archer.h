@@ -3,3 +3,52 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogArcher, Log, All);
+
+// 'stat archer' shows what archer gameplay code costs per frame
+DECLARE_STATS_GROUP(TEXT("Archer"), STATGROUP_Archer, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shoot"), STAT_ArcherShoot, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Launch Projectile"), STAT_ArcherLaunchProjectile, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Aim"), STAT_ArcherAim, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Stop Aiming"), STAT_ArcherStopAiming, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Play Montage Animation"), STAT_ArcherPlayMontageAnimation, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Move Input"), STAT_ArcherMoveInput, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Equip Weapon"), STAT_ArcherEquipWeapon, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile OnHit"), STAT_ProjectileOnHit, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Rewind Sweep"), STAT_ProjectileRewindSweep, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arrow Pool Acquire"), STAT_ArrowPoolAcquire, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arrow Pool Release"), STAT_ArrowPoolRelease, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arrow Lifetime Tick"), STAT_ArrowLifetimeTick, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arrow Simulation Integrate"), STAT_ArrowSimulationIntegrate, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arrow Simulation Traces"), STAT_ArrowSimulationTraces, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arrow Instance Commit"), STAT_ArrowInstanceCommit, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Arrow Impulse Flush"), STAT_ArrowImpulseFlush, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AI Think"), STAT_ArcherAIThink, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spatial Index Update"), STAT_ArcherSpatialIndexUpdate, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spatial Index Query"), STAT_ArcherSpatialIndexQuery, STATGROUP_Archer, ARCHER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Impact Dispatch"), STAT_ArcherImpactDispatch, STATGROUP_Archer, ARCHER_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Arrow Impulses Merged"), STAT_ArrowImpulsesMerged, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Arrow Impulse Bodies"), STAT_ArrowImpulseBodies, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("AI Bots Thought"), STAT_ArcherAIBotsThought, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impact Events"), STAT_ArcherImpactEvents, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impact Victims"), STAT_ArcherImpactVictims, STATGROUP_Archer, ARCHER_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Arrows"), STAT_LiveArrows, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Arrows"), STAT_PooledArrows, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Simulated Arrows"), STAT_SimulatedArrows, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Arrow Instances"), STAT_ArrowInstances, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Stuck Arrows"), STAT_StuckArrows, STATGROUP_Archer, ARCHER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Indexed Archers"), STAT_IndexedArchers, STATGROUP_Archer, ARCHER_API);
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Arrow Simulation Memory"), STAT_ArrowSimulationMemory, STATGROUP_Archer, ARCHER_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Arrow Instance Memory"), STAT_ArrowInstanceMemory, STATGROUP_Archer, ARCHER_API);
+
+/** Cycle counter for 'stat archer' plus a CPU scope of the same name for Unreal Insights */
+#define ARCHER_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
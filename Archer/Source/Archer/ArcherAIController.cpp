@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherAIController.h"
+#include "Archer.h"
+#include "ArcherAIDirectorSubsystem.h"
+#include "ArcherCharacter.h"
+#include "ArcherInputRecording.h"
+#include "ArcherSpatialIndexSubsystem.h"
+#include "Engine/World.h"
+#include "Projectile.h"
+
+namespace ArcherAI
+{
+	/** EquipWeapon toggles, give the equip montage and weapon streaming this long before pressing it again */
+	static const float EquipRetryDelay = 2.0f;
+}
+
+AArcherAIController::AArcherAIController(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	SightRadius = 5000.0f;
+	EngageRadius = 3000.0f;
+	TurnRate = 180.0f;
+	AimTolerance = 1.5f;
+	ShotCooldown = 1.0f;
+
+	// Control rotation is the bot's aim, keep the pawn from overwriting it
+	bSetControlRotationFromPawnOrientation = false;
+
+	bHasMoveGoal = false;
+	MoveGoal = FVector::ZeroVector;
+	LastThinkTime = -MAX_FLT;
+	LastShotTime = -MAX_FLT;
+	LastEquipTime = -MAX_FLT;
+	bWantsToSprint = false;
+}
+
+void AArcherAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	if (UArcherAIDirectorSubsystem* Director = UArcherWorldSubsystem::Get<UArcherAIDirectorSubsystem>(this))
+	{
+		Director->RegisterBot(this);
+	}
+}
+
+void AArcherAIController::OnUnPossess()
+{
+	if (UArcherAIDirectorSubsystem* Director = UArcherWorldSubsystem::Get<UArcherAIDirectorSubsystem>(this))
+	{
+		Director->UnregisterBot(this);
+	}
+
+	Target.Reset();
+	AimSolution = FArcherAimSolution();
+	bHasMoveGoal = false;
+
+	Super::OnUnPossess();
+}
+
+void AArcherAIController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UArcherAIDirectorSubsystem* Director = UArcherWorldSubsystem::Get<UArcherAIDirectorSubsystem>(this))
+	{
+		Director->UnregisterBot(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AArcherAIController::Think()
+{
+	LastThinkTime = GetWorld()->GetTimeSeconds();
+
+	AArcherCharacter* Archer = Cast<AArcherCharacter>(GetPawn());
+	AArcherCharacter* NewTarget = Archer != NULL ? FindTarget(Archer) : NULL;
+	Target = NewTarget;
+	AimSolution = FArcherAimSolution();
+	bHasMoveGoal = false;
+	if (NewTarget == NULL)
+	{
+		return;
+	}
+
+	// Out of reach or hidden, run toward it and decide again once there
+	if (FVector::DistSquared(Archer->GetActorLocation(), NewTarget->GetActorLocation()) > FMath::Square(EngageRadius) || !LineOfSightTo(NewTarget))
+	{
+		MoveGoal = NewTarget->GetActorLocation();
+		bHasMoveGoal = true;
+		return;
+	}
+
+	const TSubclassOf<AProjectile> ProjectileClass = Archer->GetProjectileClass();
+	if (ProjectileClass == NULL)
+	{
+		return;
+	}
+
+	// Bots only release fully drawn arrows
+	const FArcherBallisticParams Params = FArcherBallisticParams::FromProjectileClass(ProjectileClass, GetWorld());
+	const FVector Start = Archer->GetProjectileReleaseLocation();
+	AimSolution = FArcherBallisticSolver::SolveAim(Params, FArcherAimRequest(Start, NewTarget->GetActorLocation()));
+
+	// Lead the target by where it will be when the arrow gets there
+	if (AimSolution.bIsValid)
+	{
+		const FVector LeadLocation = NewTarget->GetActorLocation() + NewTarget->GetVelocity() * AimSolution.FlightTime;
+		const FArcherAimSolution LeadSolution = FArcherBallisticSolver::SolveAim(Params, FArcherAimRequest(Start, LeadLocation));
+		if (LeadSolution.bIsValid)
+		{
+			AimSolution = LeadSolution;
+		}
+	}
+}
+
+AArcherCharacter* AArcherAIController::FindTarget(const AArcherCharacter* Archer) const
+{
+	// Only the grid cells within sight are looked at, however many archers the world has
+	const UArcherSpatialIndexSubsystem* SpatialIndex = UArcherWorldSubsystem::Get<UArcherSpatialIndexSubsystem>(this);
+	return SpatialIndex != NULL ? SpatialIndex->FindNearest(Archer->GetActorLocation(), SightRadius, Archer) : NULL;
+}
+
+void AArcherAIController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	AArcherCharacter* Archer = Cast<AArcherCharacter>(GetPawn());
+	if (Archer == NULL)
+	{
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	FArcherInputFrame Input;
+	FRotator DesiredRotation = GetControlRotation();
+	bool bShouldSprint = false;
+
+	if (!Archer->bIsWeaponEquipped && Now - LastEquipTime > ArcherAI::EquipRetryDelay)
+	{
+		Input.SetPressed(EArcherInputAction::EquipWeapon);
+		LastEquipTime = Now;
+	}
+
+	if (bHasMoveGoal)
+	{
+		const FVector ToGoal = MoveGoal - Archer->GetActorLocation();
+		DesiredRotation = FRotator(0.0f, ToGoal.Rotation().Yaw, 0.0f);
+		Input.SetMoveInput(1.0f, 0.0f);
+		bShouldSprint = true;
+		if (Archer->bIsAiming)
+		{
+			Input.SetReleased(EArcherInputAction::Aim);
+		}
+	}
+	else if (AimSolution.bIsValid && Archer->bIsWeaponEquipped)
+	{
+		DesiredRotation = AimSolution.Rotation;
+		if (!Archer->bIsAiming)
+		{
+			if (Now - LastShotTime >= ShotCooldown)
+			{
+				Input.SetPressed(EArcherInputAction::Aim);
+			}
+		}
+		else if (Archer->bIsArrowLoaded && Archer->GetDrawStrength() >= 1.0f && GetControlRotation().Equals(AimSolution.Rotation, AimTolerance))
+		{
+			// Let go of aim right after the shot, drawing again is what nocks the next arrow
+			Input.SetPressed(EArcherInputAction::Shoot);
+			Input.SetReleased(EArcherInputAction::Aim);
+			LastShotTime = Now;
+		}
+	}
+	else if (Archer->bIsAiming)
+	{
+		Input.SetReleased(EArcherInputAction::Aim);
+	}
+
+	if (bShouldSprint != bWantsToSprint)
+	{
+		if (bShouldSprint)
+		{
+			Input.SetPressed(EArcherInputAction::Sprint);
+		}
+		else
+		{
+			Input.SetReleased(EArcherInputAction::Sprint);
+		}
+		bWantsToSprint = bShouldSprint;
+	}
+
+	Input.SetControlRotation(FMath::RInterpConstantTo(GetControlRotation(), DesiredRotation, DeltaSeconds, TurnRate));
+	Archer->ApplyInputFrame(Input);
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "ArcherBallistics.h"
+#include "ArcherAIController.generated.h"
+
+class AArcherCharacter;
+
+/**
+ * Bot archer. Drives its AArcherCharacter through the same input path a player uses (AArcherCharacter::ApplyInputFrame):
+ * equips the bow, runs to the nearest archer it can see, draws and shoots.
+ * Expensive decisions (target selection, line of sight, aim solving) are made in Think(), which UArcherAIDirectorSubsystem
+ * calls round robin under a frame budget. Tick only steers toward the last decision.
+ */
+UCLASS(config = Game)
+class ARCHER_API AArcherAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AArcherAIController(const FObjectInitializer& ObjectInitializer);
+
+	/** Archers further away than this are not noticed */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = "Archer AI")
+	float SightRadius;
+
+	/** Bot closes in until the target is this near, then stands and shoots */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = "Archer AI")
+	float EngageRadius;
+
+	/** Degrees per second the bot turns its aim */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = "Archer AI")
+	float TurnRate;
+
+	/** Bot shoots once the aim is this close to the solution, in degrees */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = "Archer AI")
+	float AimTolerance;
+
+	/** Seconds between releasing an arrow and drawing the next one */
+	UPROPERTY(config, EditAnywhere, BlueprintReadWrite, Category = "Archer AI")
+	float ShotCooldown;
+
+	/** Pick a target, check line of sight and solve aim. Called by UArcherAIDirectorSubsystem within its frame budget */
+	void Think();
+
+	/** World time of the last Think() */
+	FORCEINLINE float GetLastThinkTime() const { return LastThinkTime; }
+
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	AArcherCharacter* FindTarget(const AArcherCharacter* Archer) const;
+
+	TWeakObjectPtr<AArcherCharacter> Target;
+
+	/** Aim solved by the last Think(), invalid while the target is out of sight or reach */
+	FArcherAimSolution AimSolution;
+
+	/** Where to head when the target is out of reach */
+	FVector MoveGoal;
+	bool bHasMoveGoal;
+
+	float LastThinkTime;
+	float LastShotTime;
+	float LastEquipTime;
+	bool bWantsToSprint;
+};
@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherAIDirectorSubsystem.h"
+#include "Archer.h"
+#include "ArcherAIController.h"
+#include "ArcherCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+namespace ArcherAIDirector
+{
+	/** Distance between bots spawned on the grid */
+	static const float BotSpacing = 300.0f;
+}
+
+static void SpawnArcherBots(const TArray<FString>& Args, UWorld* World)
+{
+	UArcherAIDirectorSubsystem* Director = UArcherWorldSubsystem::Get<UArcherAIDirectorSubsystem>(World);
+	if (Director == NULL)
+	{
+		return;
+	}
+
+	// In front of the local player if there is one, so the crowd is in view
+	FVector Origin = FVector(0.0f, 0.0f, 200.0f);
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	if (PlayerController != NULL && PlayerController->GetPawn() != NULL)
+	{
+		Origin = PlayerController->GetPawn()->GetActorLocation() + PlayerController->GetPawn()->GetActorForwardVector() * 1000.0f;
+	}
+
+	Director->SpawnBots(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1, Origin);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SpawnArcherBotsCommand(
+	TEXT("Archer.SpawnBots"),
+	TEXT("Spawn bot archers: Archer.SpawnBots <Count>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SpawnArcherBots));
+
+UArcherAIDirectorSubsystem::UArcherAIDirectorSubsystem()
+{
+	ThinkBudgetMs = 1.0f;
+	MinThinkInterval = 0.25f;
+	BotPawnClass = TSoftClassPtr<AArcherCharacter>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Akai_Archer_BP.Akai_Archer_BP_C")));
+
+	NextBot = 0;
+}
+
+void UArcherAIDirectorSubsystem::RegisterBot(AArcherAIController* Bot)
+{
+	if (Bot != NULL)
+	{
+		Bots.AddUnique(Bot);
+	}
+}
+
+void UArcherAIDirectorSubsystem::UnregisterBot(AArcherAIController* Bot)
+{
+	const int32 Index = Bots.IndexOfByKey(Bot);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Keep the round robin where it was, the bot after the removed one moves into its place
+	Bots.RemoveAt(Index, 1, false);
+	if (Index < NextBot)
+	{
+		--NextBot;
+	}
+}
+
+void UArcherAIDirectorSubsystem::SpawnBots(int32 Count, const FVector& Origin)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL || Count <= 0)
+	{
+		return;
+	}
+
+	// Bare AArcherCharacter has no mesh to aim from, only a last resort
+	UClass* PawnClass = BotPawnClass.LoadSynchronous();
+	if (PawnClass == NULL)
+	{
+		AGameModeBase* GameMode = World->GetAuthGameMode();
+		PawnClass = GameMode != NULL ? GameMode->DefaultPawnClass.Get() : NULL;
+	}
+	if (PawnClass == NULL || !PawnClass->IsChildOf(AArcherCharacter::StaticClass()))
+	{
+		UE_LOG(LogArcher, Warning, TEXT("No archer blueprint for bots, spawning %s"), *AArcherCharacter::StaticClass()->GetName());
+		PawnClass = AArcherCharacter::StaticClass();
+	}
+
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(float(Count)));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector Location = Origin + FVector((Index / GridSize) * ArcherAIDirector::BotSpacing, (Index % GridSize) * ArcherAIDirector::BotSpacing, 0.0f);
+		AArcherCharacter* Archer = World->SpawnActor<AArcherCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Archer != NULL)
+		{
+			Archer->AIControllerClass = AArcherAIController::StaticClass();
+			Archer->SpawnDefaultController();
+		}
+	}
+
+	UE_LOG(LogArcher, Display, TEXT("Spawned %d bot archers, %d bots in the world"), Count, Bots.Num());
+}
+
+void UArcherAIDirectorSubsystem::Tick(float DeltaTime)
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherAIThink);
+
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + ThinkBudgetMs / 1000.0;
+
+	// Every bot gets at most one go per frame, the round robin resumes next frame where the budget ran out
+	int32 NumThought = 0;
+	for (int32 NumVisited = 0; NumVisited < Bots.Num(); ++NumVisited)
+	{
+		if (NextBot >= Bots.Num())
+		{
+			NextBot = 0;
+		}
+
+		AArcherAIController* Bot = Bots[NextBot].Get();
+		if (Bot == NULL)
+		{
+			Bots.RemoveAt(NextBot, 1, false);
+			--NumVisited;
+			continue;
+		}
+		++NextBot;
+
+		if (Now - Bot->GetLastThinkTime() < MinThinkInterval)
+		{
+			continue;
+		}
+
+		Bot->Think();
+		++NumThought;
+
+		if (FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ArcherAIBotsThought, NumThought);
+}
+
+bool UArcherAIDirectorSubsystem::IsTickable() const
+{
+	return Bots.Num() > 0;
+}
+
+ETickableTickType UArcherAIDirectorSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UArcherAIDirectorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UArcherAIDirectorSubsystem, STATGROUP_Tickables);
+}
+
+void UArcherAIDirectorSubsystem::ResetWorldState()
+{
+	Bots.Reset();
+	NextBot = 0;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArcherAIDirectorSubsystem.generated.h"
+
+class AArcherAIController;
+class AArcherCharacter;
+
+/**
+ * Shares a fixed per-frame budget for bot decisions among all AArcherAIController bots of the world.
+ * Bots think round robin, starting each frame where the last one stopped, until the budget is used up,
+ * so a crowd of bots costs the same per frame as a handful. More bots only means each thinks less often.
+ * 'Archer.SpawnBots <Count>' spawns bot archers for load tests.
+ */
+UCLASS(config = Game)
+class ARCHER_API UArcherAIDirectorSubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UArcherAIDirectorSubsystem();
+
+	/** Milliseconds per frame all bots together may spend thinking, at least one bot thinks every frame */
+	UPROPERTY(config, EditAnywhere, Category = "Archer AI")
+	float ThinkBudgetMs;
+
+	/** Seconds a bot waits between thoughts even when the budget would allow more */
+	UPROPERTY(config, EditAnywhere, Category = "Archer AI")
+	float MinThinkInterval;
+
+	/** Archer spawned for bots, needs the mesh and animations of a real archer. Falls back to the game mode's pawn class */
+	UPROPERTY(config, EditAnywhere, Category = "Archer AI")
+	TSoftClassPtr<AArcherCharacter> BotPawnClass;
+
+	void RegisterBot(AArcherAIController* Bot);
+	void UnregisterBot(AArcherAIController* Bot);
+
+	/** Returns number of registered bots */
+	int32 GetNumBots() const { return Bots.Num(); }
+
+	/** Spawn bot archers of BotPawnClass on a grid around Origin */
+	void SpawnBots(int32 Count, const FVector& Origin);
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	TArray<TWeakObjectPtr<AArcherAIController>> Bots;
+
+	/** Bot to think first next frame */
+	int32 NextBot;
+};
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherAnimInstance.h"
+#include "ArcherCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+void FArcherAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	Super::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	const AArcherCharacter* Archer = Cast<AArcherCharacter>(InAnimInstance->TryGetPawnOwner());
+	if (Archer == NULL)
+	{
+		return;
+	}
+
+	Velocity = Archer->GetVelocity();
+	ActorRotation = Archer->GetActorRotation();
+	// Replicated for simulated proxies, unlike the control rotation
+	AimRotation = Archer->GetBaseAimRotation();
+	MaxUpperBodyRotation = Archer->MaxUpperBodyRotation;
+	bIsFalling = Archer->GetCharacterMovement()->IsFalling();
+	bOwnerIsAiming = Archer->bIsAiming;
+	bOwnerHasWeaponEquipped = Archer->bIsWeaponEquipped;
+	bOwnerHasArrowLoaded = Archer->bIsArrowLoaded;
+}
+
+void FArcherAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	Super::Update(DeltaSeconds);
+
+	const FVector HorizontalVelocity(Velocity.X, Velocity.Y, 0.0f);
+	Speed = HorizontalVelocity.Size();
+	Direction = Speed > KINDA_SMALL_NUMBER ? (HorizontalVelocity.Rotation() - ActorRotation).GetNormalized().Yaw : 0.0f;
+	bIsInAir = bIsFalling;
+
+	const FRotator AimDelta = (AimRotation - ActorRotation).GetNormalized();
+	AimPitch = FMath::ClampAngle(AimDelta.Pitch, -90.0f, 90.0f);
+	AimYaw = FMath::ClampAngle(AimDelta.Yaw, -MaxUpperBodyRotation, MaxUpperBodyRotation);
+
+	bIsAiming = bOwnerIsAiming;
+	bIsWeaponEquipped = bOwnerHasWeaponEquipped;
+	bIsArrowLoaded = bOwnerHasArrowLoaded;
+}
+
+void UArcherAnimInstance::AnimNotify_ArrowLoaded()
+{
+	if (AArcherCharacter* Archer = GetArcher())
+	{
+		Archer->SetArrowLoaded(true);
+	}
+}
+
+void UArcherAnimInstance::AnimNotify_ArrowUnloaded()
+{
+	if (AArcherCharacter* Archer = GetArcher())
+	{
+		Archer->SetArrowLoaded(false);
+	}
+}
+
+FAnimInstanceProxy* UArcherAnimInstance::CreateAnimInstanceProxy()
+{
+	return &Proxy;
+}
+
+void UArcherAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+	// Proxy is a member, nothing to free
+}
+
+AArcherCharacter* UArcherAnimInstance::GetArcher() const
+{
+	return Cast<AArcherCharacter>(TryGetPawnOwner());
+}
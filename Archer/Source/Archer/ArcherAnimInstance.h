@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "ArcherAnimInstance.generated.h"
+
+class AArcherCharacter;
+
+/**
+ * Locomotion, aim and weapon state of an archer, evaluated on an animation worker thread.
+ * Game thread state is copied in PreUpdate, everything else happens in Update so anim graphs never touch the character.
+ */
+USTRUCT(BlueprintType)
+struct ARCHER_API FArcherAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FArcherAnimInstanceProxy()
+		: FAnimInstanceProxy()
+	{
+	}
+
+	FArcherAnimInstanceProxy(UAnimInstance* Instance)
+		: FAnimInstanceProxy(Instance)
+	{
+	}
+
+	/** Horizontal speed, cm/s */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Locomotion)
+	float Speed = 0.0f;
+
+	/** Angle between velocity and facing, -180..180 */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Locomotion)
+	float Direction = 0.0f;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Locomotion)
+	bool bIsInAir = false;
+
+	/** Upper body pitch towards the aim direction */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Aim)
+	float AimPitch = 0.0f;
+
+	/** Upper body yaw towards the aim direction, limited by AArcherCharacter::MaxUpperBodyRotation */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Aim)
+	float AimYaw = 0.0f;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Aim)
+	bool bIsAiming = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Weapon)
+	bool bIsWeaponEquipped = false;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Weapon)
+	bool bIsArrowLoaded = false;
+
+protected:
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	virtual void Update(float DeltaSeconds) override;
+
+private:
+	// Copied from the character on the game thread
+	FVector Velocity = FVector::ZeroVector;
+	FRotator ActorRotation = FRotator::ZeroRotator;
+	FRotator AimRotation = FRotator::ZeroRotator;
+	float MaxUpperBodyRotation = 90.0f;
+	bool bIsFalling = false;
+	bool bOwnerIsAiming = false;
+	bool bOwnerHasWeaponEquipped = false;
+	bool bOwnerHasArrowLoaded = false;
+};
+
+/**
+ * Native base for the archer animation blueprint.
+ * Anim graphs read state from Proxy, which lets the engine run their update on worker threads.
+ */
+UCLASS(Transient, Blueprintable)
+class ARCHER_API UArcherAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+	/** Fired by the draw arrow montage once the arrow is nocked */
+	UFUNCTION()
+	void AnimNotify_ArrowLoaded();
+
+	/** Fired by the reversed draw arrow montage once the arrow is back in the quiver */
+	UFUNCTION()
+	void AnimNotify_ArrowUnloaded();
+
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+
+private:
+	UPROPERTY(Transient, BlueprintReadOnly, Category = Archer, meta = (AllowPrivateAccess = "true"))
+	FArcherAnimInstanceProxy Proxy;
+
+	AArcherCharacter* GetArcher() const;
+};
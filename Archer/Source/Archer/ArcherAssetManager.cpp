@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherAssetManager.h"
+#include "Engine/Texture.h"
+#include "Materials/MaterialInterface.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectHash.h"
+
+#if WITH_EDITOR
+#include "Interfaces/ITargetPlatform.h"
+
+bool UArcherAssetManager::ShouldCookForPlatform(const UPackage* Package, const ITargetPlatform* TargetPlatform)
+{
+	if (TargetPlatform != NULL && TargetPlatform->IsServerOnly())
+	{
+		const FString PackageName = Package->GetName();
+		for (const FString& Path : CosmeticContentPaths)
+		{
+			if (PackageName.StartsWith(Path)
+				&& (FindObjectWithOuter(const_cast<UPackage*>(Package), UTexture::StaticClass()) != NULL
+					|| FindObjectWithOuter(const_cast<UPackage*>(Package), UMaterialInterface::StaticClass()) != NULL))
+			{
+				return false;
+			}
+		}
+	}
+
+	return Super::ShouldCookForPlatform(Package, TargetPlatform);
+}
+#endif
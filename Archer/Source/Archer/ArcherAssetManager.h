@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetManager.h"
+#include "ArcherAssetManager.generated.h"
+
+/**
+ * Asset manager that keeps purely cosmetic content out of dedicated server cooks.
+ * Textures and materials under CosmeticContentPaths are never loaded by a server, so they are not cooked for it.
+ */
+UCLASS(config = Game)
+class ARCHER_API UArcherAssetManager : public UAssetManager
+{
+	GENERATED_BODY()
+
+public:
+	/** Content folders whose textures and materials are left out of server-only platforms */
+	UPROPERTY(config)
+	TArray<FString> CosmeticContentPaths;
+
+#if WITH_EDITOR
+	virtual bool ShouldCookForPlatform(const UPackage* Package, const ITargetPlatform* TargetPlatform) override;
+#endif
+};
@@ -0,0 +1,316 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherBallistics.h"
+#include "Archer.h"
+#include "Projectile.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+
+namespace ArcherBallistics
+{
+	/** Pitch range searched for launch angles when drag rules out the closed form */
+	static const float MinPitch = -85.0f;
+	static const float MaxPitch = 85.0f;
+	static const float PitchScanStep = 5.0f;
+
+	/** Bisection steps after the scan, 5 degrees halved this often is well below a hundredth of a degree */
+	static const int32 NumBisections = 12;
+
+	/** Requests solved by one worker in one go, fewer are solved right on the calling thread */
+	static const int32 MinRequestsPerWorker = 8;
+}
+
+FArcherBallisticParams::FArcherBallisticParams()
+	: LaunchSpeed(6000.0f)
+	, GravityZ(-980.0f)
+	, DragCoefficient(0.0f)
+	, TimeStep(1.0f / 60.0f)
+	, MaxFlightTime(10.0f)
+	, TraceChannel(ECC_WorldDynamic)
+{
+}
+
+FArcherBallisticParams FArcherBallisticParams::FromProjectileClass(TSubclassOf<AProjectile> ProjectileClass, const UWorld* World, float SpeedScale)
+{
+	FArcherBallisticParams Params;
+	Params.GravityZ = World != NULL ? World->GetGravityZ() : UPhysicsSettings::Get()->DefaultGravityZ;
+
+	const AProjectile* ProjectileDefaults = ProjectileClass != NULL ? ProjectileClass->GetDefaultObject<AProjectile>() : nullptr;
+	if (ProjectileDefaults != NULL)
+	{
+		const UProjectileMovementComponent* MovementDefaults = ProjectileDefaults->GetProjectileMovement();
+		Params.LaunchSpeed = MovementDefaults->InitialSpeed;
+		Params.GravityZ *= MovementDefaults->ProjectileGravityScale;
+		// Projectile movement component knows no drag, only batched arrows slow down
+		Params.DragCoefficient = ProjectileDefaults->SimulationMode == EArrowSimulationMode::Batched ? ProjectileDefaults->DragCoefficient : 0.0f;
+
+		// Trace with what the arrow itself collides as and with
+		const UPrimitiveComponent* CollisionDefaults = ProjectileDefaults->GetCollisionComp();
+		Params.TraceChannel = CollisionDefaults->GetCollisionObjectType();
+		Params.TraceResponse = FCollisionResponseParams(CollisionDefaults->GetCollisionResponseToChannels());
+	}
+	Params.LaunchSpeed *= SpeedScale;
+	return Params;
+}
+
+FArcherTrajectory::FArcherTrajectory()
+	: bHit(false)
+	, FlightTime(0.0f)
+{
+}
+
+FArcherAimRequest::FArcherAimRequest()
+	: Start(ForceInitToZero)
+	, Target(ForceInitToZero)
+	, bHighArc(false)
+{
+}
+
+FArcherAimRequest::FArcherAimRequest(const FVector& InStart, const FVector& InTarget, bool bInHighArc)
+	: Start(InStart)
+	, Target(InTarget)
+	, bHighArc(bInHighArc)
+{
+}
+
+FArcherAimSolution::FArcherAimSolution()
+	: bIsValid(false)
+	, Rotation(ForceInitToZero)
+	, FlightTime(0.0f)
+{
+}
+
+void FArcherBallisticSolver::Step(const FArcherBallisticParams& Params, FVector& Position, FVector& Velocity)
+{
+	const FVector DragAcceleration = Velocity * (-Params.DragCoefficient * Velocity.Size());
+	Velocity += (DragAcceleration + FVector(0.0f, 0.0f, Params.GravityZ)) * Params.TimeStep;
+	Position += Velocity * Params.TimeStep;
+}
+
+bool FArcherBallisticSolver::PredictTrajectory(const UWorld* World, const FArcherBallisticParams& Params, const FVector& Start, const FRotator& Rotation, const AActor* IgnoredActor, FArcherTrajectory& OutTrajectory)
+{
+	OutTrajectory.Path.Reset();
+	OutTrajectory.Path.Add(Start);
+	OutTrajectory.bHit = false;
+	OutTrajectory.FlightTime = 0.0f;
+
+	if (World == NULL || Params.TimeStep <= 0.0f)
+	{
+		return false;
+	}
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ArcherBallistics), false, IgnoredActor);
+
+	FVector Position = Start;
+	FVector Velocity = Rotation.Vector() * Params.LaunchSpeed;
+	while (OutTrajectory.FlightTime < Params.MaxFlightTime)
+	{
+		const FVector PreviousPosition = Position;
+		Step(Params, Position, Velocity);
+
+		if (World->LineTraceSingleByChannel(OutTrajectory.Hit, PreviousPosition, Position, Params.TraceChannel, QueryParams, Params.TraceResponse))
+		{
+			OutTrajectory.bHit = true;
+			OutTrajectory.FlightTime += OutTrajectory.Hit.Time * Params.TimeStep;
+			OutTrajectory.Path.Add(OutTrajectory.Hit.Location);
+			return true;
+		}
+
+		OutTrajectory.FlightTime += Params.TimeStep;
+		OutTrajectory.Path.Add(Position);
+	}
+	return false;
+}
+
+bool FArcherBallisticSolver::GetHeightAtDistance(const FArcherBallisticParams& Params, float Pitch, float HorizontalDistance, float& OutHeight, float& OutTime)
+{
+	// X is horizontal distance, Z height, flight stays in the vertical plane of the aim
+	FVector Position = FVector::ZeroVector;
+	FVector Velocity = FRotator(Pitch, 0.0f, 0.0f).Vector() * Params.LaunchSpeed;
+
+	for (float Time = 0.0f; Time < Params.MaxFlightTime; Time += Params.TimeStep)
+	{
+		const FVector PreviousPosition = Position;
+		Step(Params, Position, Velocity);
+
+		if (Position.X >= HorizontalDistance)
+		{
+			const float Alpha = (HorizontalDistance - PreviousPosition.X) / FMath::Max(Position.X - PreviousPosition.X, KINDA_SMALL_NUMBER);
+			OutHeight = FMath::Lerp(PreviousPosition.Z, Position.Z, Alpha);
+			OutTime = Time + Alpha * Params.TimeStep;
+			return true;
+		}
+
+		// Falling and slowing down, it won't get any further
+		if (Velocity.X <= KINDA_SMALL_NUMBER)
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+FArcherAimSolution FArcherBallisticSolver::SolveAim(const FArcherBallisticParams& Params, const FArcherAimRequest& Request)
+{
+	FArcherAimSolution Solution;
+
+	const FVector Delta = Request.Target - Request.Start;
+	const float Distance = Delta.Size2D();
+	const float Height = Delta.Z;
+	const float Yaw = FMath::RadiansToDegrees(FMath::Atan2(Delta.Y, Delta.X));
+	const float Speed = Params.LaunchSpeed;
+	const float Gravity = -Params.GravityZ;
+
+	if (Speed <= KINDA_SMALL_NUMBER || Distance <= KINDA_SMALL_NUMBER)
+	{
+		return Solution;
+	}
+
+	if (Params.DragCoefficient <= 0.0f)
+	{
+		// Closed form: tan(pitch) = (v^2 -+ sqrt(v^4 - g(g x^2 + 2 y v^2))) / (g x)
+		float Pitch = 0.0f;
+		if (FMath::Abs(Gravity) <= KINDA_SMALL_NUMBER)
+		{
+			Pitch = FMath::RadiansToDegrees(FMath::Atan2(Height, Distance));
+		}
+		else
+		{
+			const float SpeedSquared = Speed * Speed;
+			const float Discriminant = SpeedSquared * SpeedSquared - Gravity * (Gravity * Distance * Distance + 2.0f * Height * SpeedSquared);
+			if (Discriminant < 0.0f)
+			{
+				return Solution;
+			}
+			const float Root = FMath::Sqrt(Discriminant);
+			Pitch = FMath::RadiansToDegrees(FMath::Atan((SpeedSquared + (Request.bHighArc ? Root : -Root)) / (Gravity * Distance)));
+		}
+
+		Solution.bIsValid = true;
+		Solution.Rotation = FRotator(Pitch, Yaw, 0.0f);
+		Solution.FlightTime = Distance / (Speed * FMath::Cos(FMath::DegreesToRadians(Pitch)));
+		return Solution;
+	}
+
+	// With drag: scan pitch for where the arc crosses the target height, then narrow it down by bisection.
+	// Height at the target distance rises with pitch up to the arc reaching furthest and falls after it,
+	// the flat arc is the first upward crossing and the high arc the last downward one.
+	float LowPitch = 0.0f;
+	float HighPitch = 0.0f;
+	bool bFoundBracket = false;
+	float PreviousError = 0.0f;
+	bool bPreviousValid = false;
+	for (float Pitch = ArcherBallistics::MinPitch; Pitch <= ArcherBallistics::MaxPitch; Pitch += ArcherBallistics::PitchScanStep)
+	{
+		float ArcHeight = 0.0f;
+		float Time = 0.0f;
+		const bool bValid = GetHeightAtDistance(Params, Pitch, Distance, ArcHeight, Time);
+		const float Error = ArcHeight - Height;
+
+		if (bValid && bPreviousValid)
+		{
+			const bool bCrossesUp = PreviousError < 0.0f && Error >= 0.0f;
+			const bool bCrossesDown = PreviousError >= 0.0f && Error < 0.0f;
+			if ((!Request.bHighArc && bCrossesUp) || (Request.bHighArc && bCrossesDown))
+			{
+				LowPitch = Pitch - ArcherBallistics::PitchScanStep;
+				HighPitch = Pitch;
+				bFoundBracket = true;
+				if (!Request.bHighArc)
+				{
+					break;
+				}
+			}
+		}
+		PreviousError = Error;
+		bPreviousValid = bValid;
+	}
+
+	if (!bFoundBracket)
+	{
+		return Solution;
+	}
+
+	// Keep LowPitch on the side that falls short for the flat arc and overshoots for the high one
+	float Time = 0.0f;
+	for (int32 Iteration = 0; Iteration < ArcherBallistics::NumBisections; ++Iteration)
+	{
+		const float MidPitch = (LowPitch + HighPitch) * 0.5f;
+		float ArcHeight = 0.0f;
+		const bool bFallsShort = !GetHeightAtDistance(Params, MidPitch, Distance, ArcHeight, Time) || ArcHeight < Height;
+		if (bFallsShort != Request.bHighArc)
+		{
+			LowPitch = MidPitch;
+		}
+		else
+		{
+			HighPitch = MidPitch;
+		}
+	}
+
+	const float Pitch = (LowPitch + HighPitch) * 0.5f;
+	float ArcHeight = 0.0f;
+	Solution.bIsValid = GetHeightAtDistance(Params, Pitch, Distance, ArcHeight, Time);
+	Solution.Rotation = FRotator(Pitch, Yaw, 0.0f);
+	Solution.FlightTime = Time;
+	return Solution;
+}
+
+void FArcherBallisticSolver::SolveAimBatch(const FArcherBallisticParams& Params, const TArray<FArcherAimRequest>& Requests, TArray<FArcherAimSolution>& OutSolutions)
+{
+	OutSolutions.SetNum(Requests.Num());
+
+	const int32 NumBatches = FMath::DivideAndRoundUp(Requests.Num(), ArcherBallistics::MinRequestsPerWorker);
+	ParallelFor(NumBatches, [&Params, &Requests, &OutSolutions](int32 BatchIndex)
+	{
+		const int32 First = BatchIndex * ArcherBallistics::MinRequestsPerWorker;
+		const int32 Last = FMath::Min(First + ArcherBallistics::MinRequestsPerWorker, Requests.Num());
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			OutSolutions[Index] = SolveAim(Params, Requests[Index]);
+		}
+	}, NumBatches <= 1);
+}
+
+TFuture<TArray<FArcherAimSolution>> FArcherBallisticSolver::SolveAimBatchAsync(const FArcherBallisticParams& Params, TArray<FArcherAimRequest> Requests)
+{
+	return Async(EAsyncExecution::TaskGraph, [Params, Requests = MoveTemp(Requests)]()
+	{
+		TArray<FArcherAimSolution> Solutions;
+		SolveAimBatch(Params, Requests, Solutions);
+		return Solutions;
+	});
+}
+
+FArcherTrajectoryCache::FArcherTrajectoryCache()
+	: LocationTolerance(2.0f)
+	, AngleTolerance(0.25f)
+	, CachedStart(ForceInitToZero)
+	, CachedRotation(ForceInitToZero)
+	, CachedLaunchSpeed(0.0f)
+	, bIsValid(false)
+{
+}
+
+const FArcherTrajectory& FArcherTrajectoryCache::Update(const UWorld* World, const FArcherBallisticParams& Params, const FVector& Start, const FRotator& Rotation, const AActor* IgnoredActor)
+{
+	const bool bAimChanged = !bIsValid
+		|| !FVector::PointsAreNear(Start, CachedStart, LocationTolerance)
+		|| !Rotation.Equals(CachedRotation, AngleTolerance)
+		|| !FMath::IsNearlyEqual(Params.LaunchSpeed, CachedLaunchSpeed, 1.0f);
+
+	if (bAimChanged)
+	{
+		FArcherBallisticSolver::PredictTrajectory(World, Params, Start, Rotation, IgnoredActor, Trajectory);
+		CachedStart = Start;
+		CachedRotation = Rotation;
+		CachedLaunchSpeed = Params.LaunchSpeed;
+		bIsValid = true;
+	}
+	return Trajectory;
+}
@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "CollisionQueryParams.h"
+#include "Engine/EngineTypes.h"
+#include "Templates/SubclassOf.h"
+
+class AActor;
+class AProjectile;
+class UWorld;
+
+/** How an arrow flies, read from its projectile class so predictions match the simulation */
+struct ARCHER_API FArcherBallisticParams
+{
+	/** Launch speed, cm/s */
+	float LaunchSpeed;
+
+	/** Gravity acceleration along Z, negative is down */
+	float GravityZ;
+
+	/** Quadratic air drag, deceleration is DragCoefficient * Speed^2 */
+	float DragCoefficient;
+
+	/** Integration step in seconds, smaller is more precise and slower */
+	float TimeStep;
+
+	/** Prediction stops after this many seconds of flight */
+	float MaxFlightTime;
+
+	/** Channel the path is traced on, the arrow's collision object type */
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+
+	/** What the path is stopped by, the arrow's collision responses */
+	FCollisionResponseParams TraceResponse;
+
+	FArcherBallisticParams();
+
+	/**
+	 * Flight parameters of arrows of a projectile class
+	 * @param ProjectileClass - class whose defaults (speed, gravity scale, drag, simulation mode, collision) describe the arrow
+	 * @param World - world gravity is taken from, project default gravity when NULL
+	 * @param SpeedScale - fraction of the class launch speed, like draw strength of a shot
+	 */
+	static FArcherBallisticParams FromProjectileClass(TSubclassOf<AProjectile> ProjectileClass, const UWorld* World, float SpeedScale = 1.0f);
+};
+
+/** Predicted flight of one arrow */
+struct ARCHER_API FArcherTrajectory
+{
+	/** Arrow positions every time step, the last one is the impact point or where prediction stopped */
+	TArray<FVector> Path;
+
+	/** What the arrow hits, valid if bHit */
+	FHitResult Hit;
+
+	bool bHit;
+
+	float FlightTime;
+
+	FArcherTrajectory();
+
+	FVector GetEndPoint() const { return Path.Num() > 0 ? Path.Last() : FVector::ZeroVector; }
+};
+
+/** Where an archer wants to hit */
+struct ARCHER_API FArcherAimRequest
+{
+	FVector Start;
+	FVector Target;
+	/** Lob over obstacles instead of taking the flat arc */
+	bool bHighArc;
+
+	FArcherAimRequest();
+	FArcherAimRequest(const FVector& InStart, const FVector& InTarget, bool bInHighArc = false);
+};
+
+/** Launch direction that hits an aim request target */
+struct ARCHER_API FArcherAimSolution
+{
+	/** False if the target is out of range */
+	bool bIsValid;
+	FRotator Rotation;
+	float FlightTime;
+
+	FArcherAimSolution();
+};
+
+/**
+ * Arrow flight prediction, integrated the same way as AArrowSimulationManager flies batched arrows.
+ * Everything but PredictTrajectory() is pure math and safe to run on any thread.
+ */
+class ARCHER_API FArcherBallisticSolver
+{
+public:
+	/** Advance arrow by one time step of Params: quadratic drag against the direction of flight, then gravity, then position */
+	static void Step(const FArcherBallisticParams& Params, FVector& Position, FVector& Velocity);
+
+	/**
+	 * Fly an arrow through the world until it hits something blocking the Projectile profile
+	 * @return true if the arrow hits something within Params.MaxFlightTime
+	 */
+	static bool PredictTrajectory(const UWorld* World, const FArcherBallisticParams& Params, const FVector& Start, const FRotator& Rotation, const AActor* IgnoredActor, FArcherTrajectory& OutTrajectory);
+
+	/** Find launch rotation that passes through the request target, ignores anything in the way */
+	static FArcherAimSolution SolveAim(const FArcherBallisticParams& Params, const FArcherAimRequest& Request);
+
+	/** Solve many aim requests at once spread over worker threads, OutSolutions matches Requests by index */
+	static void SolveAimBatch(const FArcherBallisticParams& Params, const TArray<FArcherAimRequest>& Requests, TArray<FArcherAimSolution>& OutSolutions);
+
+	/** SolveAimBatch() in the background, the game thread picks the solutions up once the future is ready */
+	static TFuture<TArray<FArcherAimSolution>> SolveAimBatchAsync(const FArcherBallisticParams& Params, TArray<FArcherAimRequest> Requests);
+
+private:
+	/**
+	 * Fly in the vertical plane until HorizontalDistance is covered
+	 * @return false if the arrow never gets that far
+	 */
+	static bool GetHeightAtDistance(const FArcherBallisticParams& Params, float Pitch, float HorizontalDistance, float& OutHeight, float& OutTime);
+};
+
+/** Keeps the last predicted trajectory and only predicts again once the aim moved past the tolerances */
+struct ARCHER_API FArcherTrajectoryCache
+{
+	/** Start may move this far, in cm, before the trajectory is predicted again */
+	float LocationTolerance;
+
+	/** Aim may turn this much, in degrees, before the trajectory is predicted again */
+	float AngleTolerance;
+
+	FArcherTrajectoryCache();
+
+	/** Returns trajectory for the aim, predicted again only if it changed enough since the last call */
+	const FArcherTrajectory& Update(const UWorld* World, const FArcherBallisticParams& Params, const FVector& Start, const FRotator& Rotation, const AActor* IgnoredActor);
+
+	/** Predict again on the next Update(), call when the world around the trajectory changed */
+	void Invalidate() { bIsValid = false; }
+
+private:
+	FArcherTrajectory Trajectory;
+	FVector CachedStart;
+	FRotator CachedRotation;
+	float CachedLaunchSpeed;
+	bool bIsValid;
+};
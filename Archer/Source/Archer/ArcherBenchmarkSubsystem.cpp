@@ -0,0 +1,490 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherBenchmarkSubsystem.h"
+#include "Archer.h"
+#include "ArcherCharacter.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace ArcherBenchmark
+{
+	/** Seed for fire direction spread, fixed so every run shoots the same arrows */
+	static const int32 RandomSeed = 0x41524348;
+
+	/** Distance between archers spawned on the grid */
+	static const float ArcherSpacing = 250.0f;
+
+	static void ParseList(const TCHAR* Switch, const TCHAR* Default, TArray<FString>& OutValues)
+	{
+		FString Value;
+		if (!FParse::Value(FCommandLine::Get(), Switch, Value))
+		{
+			Value = Default;
+		}
+		Value.ParseIntoArray(OutValues, TEXT(","), true);
+	}
+}
+
+void FArcherBenchmarkPhysicsTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Benchmark != NULL)
+	{
+		Benchmark->OnPhysicsMarker(bIsStartMarker);
+	}
+}
+
+FString FArcherBenchmarkPhysicsTickFunction::DiagnosticMessage()
+{
+	return bIsStartMarker ? TEXT("ArcherBenchmark[PhysicsStart]") : TEXT("ArcherBenchmark[PhysicsEnd]");
+}
+
+FString UArcherBenchmarkSubsystem::FScenarioResult::GetKey() const
+{
+	return FString::Printf(TEXT("%d_%g"), NumArchers, FireRate);
+}
+
+bool UArcherBenchmarkSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("ArcherBenchmark"));
+}
+
+void UArcherBenchmarkSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	TArray<FString> Counts;
+	TArray<FString> FireRates;
+	ArcherBenchmark::ParseList(TEXT("ArcherCounts="), TEXT("8,32,128"), Counts);
+	ArcherBenchmark::ParseList(TEXT("ArcherFireRates="), TEXT("1,4"), FireRates);
+	for (const FString& Count : Counts)
+	{
+		for (const FString& FireRate : FireRates)
+		{
+			FScenario Scenario;
+			Scenario.NumArchers = FMath::Max(FCString::Atoi(*Count), 1);
+			Scenario.FireRate = FMath::Max(FCString::Atof(*FireRate), 0.1f);
+			Scenarios.Add(Scenario);
+		}
+	}
+
+	WarmupSeconds = 2.0f;
+	DurationSeconds = 10.0f;
+	TolerancePercent = 10.0f;
+	FParse::Value(CommandLine, TEXT("ArcherWarmup="), WarmupSeconds);
+	FParse::Value(CommandLine, TEXT("ArcherDuration="), DurationSeconds);
+	FParse::Value(CommandLine, TEXT("ArcherTolerance="), TolerancePercent);
+
+	ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmark/ArcherBenchmark");
+	BaselinePath = FPaths::ProjectDir() / TEXT("Benchmark/ArcherBenchmarkBaseline.json");
+	FParse::Value(CommandLine, TEXT("ArcherReport="), ReportPath);
+	FParse::Value(CommandLine, TEXT("ArcherBaseline="), BaselinePath);
+	bWriteBaseline = FParse::Param(CommandLine, TEXT("ArcherWriteBaseline"));
+
+	CurrentScenario = INDEX_NONE;
+	Phase = EPhase::WaitingForWorld;
+	PhaseEndTime = 0.0;
+	PhysicsStartTime = 0.0;
+	GCStartTime = 0.0;
+
+	PhysicsStartTick.Benchmark = this;
+	PhysicsStartTick.bIsStartMarker = true;
+	PhysicsStartTick.TickGroup = TG_StartPhysics;
+	PhysicsStartTick.bCanEverTick = true;
+
+	PhysicsEndTick.Benchmark = this;
+	PhysicsEndTick.bIsStartMarker = false;
+	PhysicsEndTick.TickGroup = TG_PostPhysics;
+	PhysicsEndTick.bCanEverTick = true;
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UArcherBenchmarkSubsystem::OnPostLoadMap);
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UArcherBenchmarkSubsystem::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UArcherBenchmarkSubsystem::OnPostGarbageCollect);
+
+	UE_LOG(LogArcher, Display, TEXT("Archer benchmark enabled, %d scenarios"), Scenarios.Num());
+}
+
+void UArcherBenchmarkSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	Super::Deinitialize();
+}
+
+void UArcherBenchmarkSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	if (Phase != EPhase::WaitingForWorld || LoadedWorld == NULL || LoadedWorld != GetWorld())
+	{
+		return;
+	}
+
+	PhysicsStartTick.RegisterTickFunction(LoadedWorld->PersistentLevel);
+	PhysicsEndTick.RegisterTickFunction(LoadedWorld->PersistentLevel);
+
+	RandomStream.Initialize(ArcherBenchmark::RandomSeed);
+	StartScenario(0);
+}
+
+void UArcherBenchmarkSubsystem::Tick(float DeltaTime)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL || (Phase != EPhase::Warmup && Phase != EPhase::Measure))
+	{
+		return;
+	}
+
+	FireDueArchers(DeltaTime);
+
+	const double Now = FPlatformTime::Seconds();
+	if (Phase == EPhase::Measure)
+	{
+		const FArcherFrameTiming& Timing = FrameTimings.RecordFrame();
+		++Current.NumFrames;
+		Current.GameThreadMs += Timing.GameThreadMs;
+		Current.FrameMs += Timing.FrameMs;
+
+		const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+		Current.PeakUsedPhysicalMB = FMath::Max(Current.PeakUsedPhysicalMB, double(MemoryStats.UsedPhysical) / (1024.0 * 1024.0));
+	}
+
+	if (Now >= PhaseEndTime)
+	{
+		if (Phase == EPhase::Warmup)
+		{
+			// Start from clean counters, warmup frames are full of first-use costs
+			Current = FScenarioResult();
+			Current.NumArchers = Scenarios[CurrentScenario].NumArchers;
+			Current.FireRate = Scenarios[CurrentScenario].FireRate;
+			Phase = EPhase::Measure;
+			PhaseEndTime = Now + DurationSeconds;
+			// Room for 120 fps, recording must not reallocate while measuring
+			FrameTimings.Start(FMath::CeilToInt(DurationSeconds * 120.0f));
+		}
+		else
+		{
+			EndScenario();
+		}
+	}
+}
+
+bool UArcherBenchmarkSubsystem::IsTickable() const
+{
+	return Phase == EPhase::Warmup || Phase == EPhase::Measure;
+}
+
+ETickableTickType UArcherBenchmarkSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UArcherBenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UArcherBenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UArcherBenchmarkSubsystem::OnPhysicsMarker(bool bIsStart)
+{
+	if (bIsStart)
+	{
+		PhysicsStartTime = FPlatformTime::Seconds();
+	}
+	else if (Phase == EPhase::Measure && PhysicsStartTime > 0.0)
+	{
+		Current.PhysicsMs += (FPlatformTime::Seconds() - PhysicsStartTime) * 1000.0;
+	}
+}
+
+void UArcherBenchmarkSubsystem::ResetWorldState()
+{
+	if (PhysicsStartTick.IsTickFunctionRegistered())
+	{
+		PhysicsStartTick.UnRegisterTickFunction();
+	}
+	if (PhysicsEndTick.IsTickFunctionRegistered())
+	{
+		PhysicsEndTick.UnRegisterTickFunction();
+	}
+	Archers.Reset();
+	TimeUntilNextShot.Reset();
+
+	// World went away in the middle of the run, report what we have
+	if (Phase == EPhase::Warmup || Phase == EPhase::Measure)
+	{
+		UE_LOG(LogArcher, Warning, TEXT("Archer benchmark world was torn down before all scenarios finished"));
+		FinishRun();
+	}
+}
+
+void UArcherBenchmarkSubsystem::StartScenario(int32 ScenarioIndex)
+{
+	if (!Scenarios.IsValidIndex(ScenarioIndex))
+	{
+		FinishRun();
+		return;
+	}
+
+	CurrentScenario = ScenarioIndex;
+	const FScenario& Scenario = Scenarios[ScenarioIndex];
+	UE_LOG(LogArcher, Display, TEXT("Archer benchmark: %d archers firing %g arrows/s"), Scenario.NumArchers, Scenario.FireRate);
+
+	SpawnArchers(Scenario.NumArchers);
+
+	Phase = EPhase::Warmup;
+	PhaseEndTime = FPlatformTime::Seconds() + WarmupSeconds;
+}
+
+void UArcherBenchmarkSubsystem::EndScenario()
+{
+	Current.FrameMsP95 = FrameTimings.Summarize().Percentile95Ms;
+	Results.Add(Current);
+	DestroyArchers();
+
+	// Arrows of this scenario must not be billed to the next one
+	if (GEngine != NULL)
+	{
+		GEngine->ForceGarbageCollection(true);
+	}
+
+	StartScenario(CurrentScenario + 1);
+}
+
+void UArcherBenchmarkSubsystem::SpawnArchers(int32 NumArchers)
+{
+	UWorld* const World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* PawnClass = GameMode != NULL ? GameMode->DefaultPawnClass.Get() : nullptr;
+	if (PawnClass == NULL || !PawnClass->IsChildOf(AArcherCharacter::StaticClass()))
+	{
+		PawnClass = AArcherCharacter::StaticClass();
+	}
+
+	// Square grid around the world origin, everybody shoots roughly the same way
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(float(NumArchers)));
+	const FVector Origin = FVector(0.0f, 0.0f, 200.0f);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 Index = 0; Index < NumArchers; ++Index)
+	{
+		const FVector Location = Origin + FVector((Index / GridSize) * ArcherBenchmark::ArcherSpacing, (Index % GridSize) * ArcherBenchmark::ArcherSpacing, 0.0f);
+		AArcherCharacter* Archer = World->SpawnActor<AArcherCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Archer != NULL)
+		{
+			// Archers never equip here, stream the arrow in during warmup
+			Archer->PreloadWeaponContent();
+			Archers.Add(Archer);
+			// Spread first shots over one period so archers don't all fire on the same frame
+			TimeUntilNextShot.Add(RandomStream.FRandRange(0.0f, 1.0f / Scenarios[CurrentScenario].FireRate));
+		}
+	}
+}
+
+void UArcherBenchmarkSubsystem::DestroyArchers()
+{
+	for (const TWeakObjectPtr<AArcherCharacter>& Archer : Archers)
+	{
+		if (Archer.IsValid())
+		{
+			Archer->Destroy();
+		}
+	}
+	Archers.Reset();
+	TimeUntilNextShot.Reset();
+}
+
+void UArcherBenchmarkSubsystem::FireDueArchers(float DeltaTime)
+{
+	const float ShotInterval = 1.0f / Scenarios[CurrentScenario].FireRate;
+
+	for (int32 Index = 0; Index < Archers.Num(); ++Index)
+	{
+		AArcherCharacter* Archer = Archers[Index].Get();
+		if (Archer == NULL)
+		{
+			continue;
+		}
+
+		TimeUntilNextShot[Index] -= DeltaTime;
+		while (TimeUntilNextShot[Index] <= 0.0f)
+		{
+			TimeUntilNextShot[Index] += ShotInterval;
+
+			// Goes straight through LaunchProjectile(), bypassing aim animations, so only arrow cost is measured
+			const FRotator Rotation(RandomStream.FRandRange(5.0f, 25.0f), Archer->GetActorRotation().Yaw + RandomStream.FRandRange(-10.0f, 10.0f), 0.0f);
+			const FVector Location = Archer->GetProjectileReleaseLocation();
+
+			const double LaunchStart = FPlatformTime::Seconds();
+			Archer->LaunchProjectile(Location, Rotation);
+			if (Phase == EPhase::Measure)
+			{
+				Current.LaunchUs += (FPlatformTime::Seconds() - LaunchStart) * 1000000.0;
+				++Current.NumShots;
+			}
+		}
+	}
+}
+
+void UArcherBenchmarkSubsystem::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void UArcherBenchmarkSubsystem::OnPostGarbageCollect()
+{
+	if (Phase == EPhase::Measure && GCStartTime > 0.0)
+	{
+		Current.GCMs += (FPlatformTime::Seconds() - GCStartTime) * 1000.0;
+	}
+	GCStartTime = 0.0;
+}
+
+void UArcherBenchmarkSubsystem::FinishRun()
+{
+	Phase = EPhase::Finished;
+	DestroyArchers();
+
+	const FString Csv = BuildCsvReport();
+	const FString Json = BuildJsonReport();
+	FFileHelper::SaveStringToFile(Csv, *(ReportPath + TEXT(".csv")));
+	FFileHelper::SaveStringToFile(Json, *(ReportPath + TEXT(".json")));
+	UE_LOG(LogArcher, Display, TEXT("Archer benchmark report written to %s.csv/.json\n%s"), *ReportPath, *Csv);
+
+	int32 NumRegressions = 0;
+	if (bWriteBaseline)
+	{
+		FFileHelper::SaveStringToFile(Json, *BaselinePath);
+		UE_LOG(LogArcher, Display, TEXT("Archer benchmark baseline written to %s"), *BaselinePath);
+	}
+	else
+	{
+		FString BaselineJson;
+		if (FFileHelper::LoadFileToString(BaselineJson, *BaselinePath))
+		{
+			NumRegressions = CompareWithBaseline(BaselineJson);
+		}
+		else
+		{
+			UE_LOG(LogArcher, Warning, TEXT("No archer benchmark baseline at %s, nothing to compare against"), *BaselinePath);
+		}
+	}
+
+	FPlatformMisc::RequestExitWithStatus(false, NumRegressions > 0 ? 1 : 0);
+}
+
+FString UArcherBenchmarkSubsystem::BuildCsvReport() const
+{
+	FString Csv = TEXT("Archers,FireRate,Frames,Shots,GameThreadMs,FrameMs,FrameMsP95,PhysicsMs,LaunchUs,GCMs,PeakUsedPhysicalMB\n");
+	for (const FScenarioResult& Result : Results)
+	{
+		const double Frames = FMath::Max(Result.NumFrames, 1);
+		const double Shots = FMath::Max(Result.NumShots, 1);
+		Csv += FString::Printf(TEXT("%d,%g,%d,%d,%.3f,%.3f,%.3f,%.3f,%.2f,%.3f,%.1f\n"),
+			Result.NumArchers, Result.FireRate, Result.NumFrames, Result.NumShots,
+			Result.GameThreadMs / Frames, Result.FrameMs / Frames, Result.FrameMsP95, Result.PhysicsMs / Frames,
+			Result.LaunchUs / Shots, Result.GCMs, Result.PeakUsedPhysicalMB);
+	}
+	return Csv;
+}
+
+FString UArcherBenchmarkSubsystem::BuildJsonReport() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("Map"), GetWorld() != NULL ? GetWorld()->GetMapName() : FString());
+
+	TSharedRef<FJsonObject> ScenarioObjects = MakeShared<FJsonObject>();
+	for (const FScenarioResult& Result : Results)
+	{
+		const double Frames = FMath::Max(Result.NumFrames, 1);
+		const double Shots = FMath::Max(Result.NumShots, 1);
+
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetNumberField(TEXT("Archers"), Result.NumArchers);
+		Object->SetNumberField(TEXT("FireRate"), Result.FireRate);
+		Object->SetNumberField(TEXT("Frames"), Result.NumFrames);
+		Object->SetNumberField(TEXT("Shots"), Result.NumShots);
+		Object->SetNumberField(TEXT("GameThreadMs"), Result.GameThreadMs / Frames);
+		Object->SetNumberField(TEXT("FrameMs"), Result.FrameMs / Frames);
+		Object->SetNumberField(TEXT("FrameMsP95"), Result.FrameMsP95);
+		Object->SetNumberField(TEXT("PhysicsMs"), Result.PhysicsMs / Frames);
+		Object->SetNumberField(TEXT("LaunchUs"), Result.LaunchUs / Shots);
+		Object->SetNumberField(TEXT("GCMs"), Result.GCMs);
+		Object->SetNumberField(TEXT("PeakUsedPhysicalMB"), Result.PeakUsedPhysicalMB);
+		ScenarioObjects->SetObjectField(Result.GetKey(), Object);
+	}
+	Root->SetObjectField(TEXT("Scenarios"), ScenarioObjects);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+	return Json;
+}
+
+int32 UArcherBenchmarkSubsystem::CompareWithBaseline(const FString& BaselineJson) const
+{
+	TSharedPtr<FJsonObject> Baseline;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(BaselineJson);
+	if (!FJsonSerializer::Deserialize(Reader, Baseline) || !Baseline.IsValid() || !Baseline->HasTypedField<EJson::Object>(TEXT("Scenarios")))
+	{
+		UE_LOG(LogArcher, Error, TEXT("Archer benchmark baseline %s can't be parsed"), *BaselinePath);
+		return 1;
+	}
+
+	TSharedPtr<FJsonObject> BaselineScenarios = Baseline->GetObjectField(TEXT("Scenarios"));
+	TSharedPtr<FJsonObject> CurrentScenarios;
+	TSharedRef<TJsonReader<>> CurrentReader = TJsonReaderFactory<>::Create(BuildJsonReport());
+	if (!FJsonSerializer::Deserialize(CurrentReader, CurrentScenarios) || !CurrentScenarios.IsValid() || !CurrentScenarios->HasTypedField<EJson::Object>(TEXT("Scenarios")))
+	{
+		UE_LOG(LogArcher, Error, TEXT("Archer benchmark results can't be parsed back for comparison"));
+		return 1;
+	}
+	CurrentScenarios = CurrentScenarios->GetObjectField(TEXT("Scenarios"));
+
+	// Lower is better for every compared metric
+	static const TCHAR* Metrics[] = { TEXT("GameThreadMs"), TEXT("PhysicsMs"), TEXT("LaunchUs"), TEXT("GCMs"), TEXT("PeakUsedPhysicalMB") };
+	const double AllowedRatio = 1.0 + TolerancePercent / 100.0;
+
+	int32 NumRegressions = 0;
+	for (const FScenarioResult& Result : Results)
+	{
+		const FString Key = Result.GetKey();
+		const TSharedPtr<FJsonObject>* BaselineScenario = nullptr;
+		if (!BaselineScenarios->TryGetObjectField(Key, BaselineScenario))
+		{
+			UE_LOG(LogArcher, Warning, TEXT("Archer benchmark scenario %s is not in the baseline"), *Key);
+			continue;
+		}
+
+		const TSharedPtr<FJsonObject> CurrentScenarioObject = CurrentScenarios->GetObjectField(Key);
+		bool bRegressed = false;
+		for (const TCHAR* Metric : Metrics)
+		{
+			const double BaselineValue = (*BaselineScenario)->GetNumberField(Metric);
+			const double CurrentValue = CurrentScenarioObject->GetNumberField(Metric);
+			if (BaselineValue > 0.0 && CurrentValue > BaselineValue * AllowedRatio)
+			{
+				UE_LOG(LogArcher, Error, TEXT("Archer benchmark regression in %s: %s %.3f, baseline %.3f"), *Key, Metric, CurrentValue, BaselineValue);
+				bRegressed = true;
+			}
+		}
+		NumRegressions += bRegressed ? 1 : 0;
+	}
+
+	UE_LOG(LogArcher, Display, TEXT("Archer benchmark: %d of %d scenarios regressed past %g%%"), NumRegressions, Results.Num(), TolerancePercent);
+	return NumRegressions;
+}
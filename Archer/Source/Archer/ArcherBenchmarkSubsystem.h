@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArcherFrameTiming.h"
+#include "ArcherBenchmarkSubsystem.generated.h"
+
+class AArcherCharacter;
+class UArcherBenchmarkSubsystem;
+
+/** Marks start or end of the physics tick groups so the benchmark can time the physics step */
+USTRUCT()
+struct FArcherBenchmarkPhysicsTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UArcherBenchmarkSubsystem* Benchmark = nullptr;
+
+	bool bIsStartMarker = false;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FArcherBenchmarkPhysicsTickFunction> : public TStructOpsTypeTraitsBase2<FArcherBenchmarkPhysicsTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Headless projectile stress benchmark. Enabled with -ArcherBenchmark on the command line, e.g.
+ *   UE4Editor Archer.uproject /Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap -game -nullrhi -unattended -ArcherBenchmark
+ *     -ArcherCounts=8,32,128 -ArcherFireRates=1,4 -ArcherWarmup=2 -ArcherDuration=10
+ *     -ArcherReport=Saved/Benchmark/Report -ArcherBaseline=Benchmark/ArcherBenchmarkBaseline.json -ArcherTolerance=10
+ * For every archer count and fire rate it spawns the archers, lets them fire arrows at a fixed cadence and measures
+ * game thread, physics, arrow launch and GC cost plus peak memory. Results are written as CSV and JSON and compared
+ * against the baseline, the process exits with code 1 if any scenario regressed past the tolerance.
+ * -ArcherWriteBaseline stores the results as new baseline instead.
+ */
+UCLASS()
+class ARCHER_API UArcherBenchmarkSubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Called from the physics tick markers */
+	void OnPhysicsMarker(bool bIsStart);
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	struct FScenario
+	{
+		int32 NumArchers;
+		float FireRate;
+	};
+
+	struct FScenarioResult
+	{
+		int32 NumArchers = 0;
+		float FireRate = 0.0f;
+		int32 NumFrames = 0;
+		int32 NumShots = 0;
+		double GameThreadMs = 0.0;
+		double FrameMs = 0.0;
+		double FrameMsP95 = 0.0;
+		double PhysicsMs = 0.0;
+		double LaunchUs = 0.0;
+		double GCMs = 0.0;
+		double PeakUsedPhysicalMB = 0.0;
+
+		FString GetKey() const;
+	};
+
+	enum class EPhase : uint8
+	{
+		WaitingForWorld,
+		Warmup,
+		Measure,
+		Finished
+	};
+
+	void OnPostLoadMap(UWorld* LoadedWorld);
+
+	void StartScenario(int32 ScenarioIndex);
+	void EndScenario();
+	void SpawnArchers(int32 NumArchers);
+	void DestroyArchers();
+	void FireDueArchers(float DeltaTime);
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	void FinishRun();
+	FString BuildCsvReport() const;
+	FString BuildJsonReport() const;
+	/** Returns number of scenarios that are worse than in the baseline by more than the tolerance */
+	int32 CompareWithBaseline(const FString& BaselineJson) const;
+
+	TArray<FScenario> Scenarios;
+	TArray<FScenarioResult> Results;
+	int32 CurrentScenario;
+	EPhase Phase;
+	double PhaseEndTime;
+
+	float WarmupSeconds;
+	float DurationSeconds;
+	float TolerancePercent;
+	FString ReportPath;
+	FString BaselinePath;
+	bool bWriteBaseline;
+
+	TArray<TWeakObjectPtr<AArcherCharacter>> Archers;
+	TArray<float> TimeUntilNextShot;
+	FRandomStream RandomStream;
+
+	FScenarioResult Current;
+	FArcherFrameTimings FrameTimings;
+	double PhysicsStartTime;
+	double GCStartTime;
+
+	FArcherBenchmarkPhysicsTickFunction PhysicsStartTick;
+	FArcherBenchmarkPhysicsTickFunction PhysicsEndTick;
+
+	FDelegateHandle PostLoadMapHandle;
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
@@ -1,23 +1,63 @@
 // Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
 
 #include "ArcherCharacter.h"
+#include "Archer.h"
+#include "AimCameraBlendComponent.h"
+#include "ArcherImpactEventSubsystem.h"
+#include "ArcherInputRecording.h"
+#include "ArcherLagCompensationComponent.h"
+#include "ArcherMovementComponent.h"
+#include "ArcherPlayerController.h"
+#include "ArcherSpatialIndexSubsystem.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequenceBase.h"
 #include "Components/StaticMeshComponent.h"
 #include "Projectile.h"
+#include "ArrowPoolSubsystem.h"
+#include "ArrowSimulationManager.h"
+#include "Engine/AssetManager.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Net/UnrealNetwork.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/GameStateBase.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Public/TimerManager.h"
 
+//////////////////////////////////////////////////////////////////////////
+// FArcherDirectionalAnimations
+
+UAnimSequenceBase* FArcherDirectionalAnimations::Pick(const FVector& LocalDirection) const
+{
+	// Archer faces along X, Y points to its right
+	if (FMath::Abs(LocalDirection.X) >= FMath::Abs(LocalDirection.Y))
+	{
+		return LocalDirection.X >= 0.0f ? Front.Get() : Back.Get();
+	}
+	return LocalDirection.Y >= 0.0f ? Right.Get() : Left.Get();
+}
+
+void FArcherDirectionalAnimations::GetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	for (const TSoftObjectPtr<UAnimSequenceBase>* Animation : { &Front, &Back, &Left, &Right })
+	{
+		if (!Animation->IsNull())
+		{
+			OutPaths.AddUnique(Animation->ToSoftObjectPath());
+		}
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 // AArcherCharacter
 
-AArcherCharacter::AArcherCharacter()
+AArcherCharacter::AArcherCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UArcherMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -51,57 +91,93 @@ AArcherCharacter::AArcherCharacter()
 	AimModeFieldOfView = 70.0f;	
 	AimModeCameraBoomSocketOffsetY = 60.0f;
 	
-	// Setting up default values for character movement
-	SprintSpeedCrouched = 187.5f;
-	RunSpeed = 375.f;
-	SprintSpeed = 562.5f;
-	WalkSpeed = 180.5f;  //  93.75f;
-	WalkSpeedCrouched = 46.87f;	
-	bWalkModeActive = false;
-	JumpWalkZVelocity = 375.f;
-	JumpRunZVelocity = 450.f;
-	JumpSprintZVelocity = 562.5f;	
-	bIsSprintingAllowed = true;	
-
 	MaxUpperBodyRotation = 90.0f;
+
+	Significance = EArcherSignificance::Full;
+
+	FullDrawTime = 0.0f;
+	MinDrawStrength = 0.5f;
+	MaxShotOriginError = 250.0f;
+	MinShotInterval = 0.2f;
+	ArrowLoadedTime = 0.0f;
+	NextShotId = 0;
+	LastServerShotTime = -MAX_FLT;
+	bEquipWhenLoaded = false;
+	DedicatedServerMeshLOD = INDEX_NONE;
+	UnanimatedNockTime = 0.5f;
+
+	MaxHealth = 100.0f;
+	Health = MaxHealth;
+	bIsDead = false;
+	HitAnimationSlot = TEXT("DefaultSlot");
+	HitReactionAnimations.Front = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Reaction/Standing_React_Small_From_Front.Standing_React_Small_From_Front")));
+	HitReactionAnimations.Back = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Reaction/Standing_React_Small_From_Back.Standing_React_Small_From_Back")));
+	HitReactionAnimations.Left = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Reaction/Standing_React_Small_From_Left.Standing_React_Small_From_Left")));
+	HitReactionAnimations.Right = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Reaction/Standing_React_Small_From_Right.Standing_React_Small_From_Right")));
+	// A hit from the front knocks the archer over backwards
+	DeathAnimations.Front = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Death/Standing_Death_Backward_01.Standing_Death_Backward_01")));
+	DeathAnimations.Back = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Death/Standing_Death_Forward_01.Standing_Death_Forward_01")));
+	DeathAnimations.Left = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Death/Standing_Death_Right_01.Standing_Death_Right_01")));
+	DeathAnimations.Right = TSoftObjectPtr<UAnimSequenceBase>(FSoftObjectPath(TEXT("/Game/Akai_Archer/Animation/Death/Standing_Death_Left_01.Standing_Death_Left_01")));
 	
-	// Configure character movement
+	// Configure character movement, walk/run/sprint speeds and jump velocities are set up in UArcherMovementComponent
 	GetCharacterMovement()->bOrientRotationToMovement = true; // Character moves in the direction of input...	
 	GetCharacterMovement()->RotationRate = FRotator(0.0f, 540.0f, 0.0f); // ...at this rotation rate
-	GetCharacterMovement()->JumpZVelocity = JumpRunZVelocity;
 	GetCharacterMovement()->AirControl = 0.2f;
-	GetCharacterMovement()->MaxWalkSpeed = RunSpeed;
-	GetCharacterMovement()->MaxWalkSpeedCrouched = WalkSpeedCrouched;	
 
-	// Create projectile static mesh component to use it in animation that require seeing a projectile
+	// Cosmetic components are left out of the dedicated server build, see ArcherServer.Target.cs
+	ProjectileMesh = NULL;
+	WeaponMesh = NULL;
+	CameraBoom = NULL;
+	FollowCamera = NULL;
+
+	// Bow and release point hang off hand sockets, see GetProjectileReleaseLocation().
+	// Offsets are those Akai_Archer_BP gave the bow mesh and the old release point component
+	WeaponSocketName = TEXT("LeftHandGripPoint");
+	WeaponSocketOffset = FTransform(FVector(-79.0f, 7.0f, -141.0f));
+	ProjectileSocketName = TEXT("RightHandGripPoint");
+	ProjectileReleaseOffset = FVector(92.0f, -8.0f, 175.0f);
+
+#if !UE_SERVER
+	// Create projectile static mesh component to use it in animation that require seeing a projectile.
+	// Hidden arrow and bow are not registered, so they don't follow the hands on every move, see SetWeaponComponentActive()
 	ProjectileMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ProjectileMesh"));		
+	ProjectileMesh->SetupAttachment(GetMesh(), ProjectileSocketName);
 	ProjectileMesh->SetHiddenInGame(true, true);
 	ProjectileMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);	
-
-	BowGripOffset = CreateDefaultSubobject<USceneComponent>(TEXT("BowGripOffset"));
-	BowGripOffset->SetupAttachment(GetMesh());
+	ProjectileMesh->bAutoRegister = false;
 
 	// Create Weapon tatic mesh component and make it hidden in game
 	WeaponMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("WeaponMesh"));	
-	WeaponMesh->SetupAttachment(BowGripOffset);
-	
+	WeaponMesh->SetupAttachment(GetMesh(), WeaponSocketName);
 	WeaponMesh->SetHiddenInGame(true, true);
+	WeaponMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	WeaponMesh->bAutoRegister = false;
+#endif
 
-	// Create point at whitch projectiles will be spawned (shoot from)
-	// TODO change attachment to the bow when separate static mesh for weapon is made.
-	ProjectileReleasePoint = CreateDefaultSubobject<USceneComponent>(TEXT("ProjectileReleasePoint"));
-	ProjectileReleasePoint->SetupAttachment(WeaponMesh);
-	
+#if !UE_SERVER
 	// Create a camera boom (pulls in towards the player if there is a collision)
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
 	CameraBoom->TargetArmLength = 300.0f; // The camera follows at this distance behind the character	
 	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	CameraBoom->PrimaryComponentTick.bStartWithTickEnabled = false; // Enabled in Restart() for the local player only
 
 	// Create a follow camera
 	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+#endif
+
+	// Record hitboxes on servers to validate hits of lagging shooters
+	LagCompensation = CreateDefaultSubobject<UArcherLagCompensationComponent>(TEXT("LagCompensation"));
+
+	// Blend camera between default and aim mode, ticks only while zooming
+	AimCameraBlend = CreateDefaultSubobject<UAimCameraBlendComponent>(TEXT("AimCameraBlend"));
+
+	// Movement, animation and camera blend tick as components, the actor itself has nothing to do per frame.
+	// Blueprint Event Tick never runs either, the camera lerp Akai_Archer_BP used to tick would fight AimCameraBlend
+	PrimaryActorTick.bCanEverTick = false;
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
@@ -112,10 +188,131 @@ void AArcherCharacter::BeginPlay()
 	// Call the base class  
 	Super::BeginPlay();
 
-	//Attach projectile mesh component to Skeleton, doing it here because the skeleton is not yet created in the constructor
-	ProjectileMesh->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("RightHandGripPoint"));
+	// Snap to the hand sockets, the blueprint may have moved the meshes in the editor
+	if (ProjectileMesh != NULL)
+	{
+		ProjectileMesh->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), ProjectileSocketName);
+	}
+	if (WeaponMesh != NULL)
+	{
+		WeaponMesh->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), WeaponSocketName);
+		WeaponMesh->SetRelativeTransform(WeaponSocketOffset);
+	}
+
+	// Servers simulate every archer's arrows whether or not their weapon is out
+	if (IsNetMode(NM_DedicatedServer) || IsNetMode(NM_ListenServer))
+	{
+		PreloadWeaponContent();
+	}
+
+	// Nothing is rendered on a dedicated server, the mesh is only posed for hit validation
+	if (IsNetMode(NM_DedicatedServer))
+	{
+		USkeletalMeshComponent* SkeletalMesh = GetMesh();
+		// Forced LOD is 1 based, 0 means automatic
+		if (DedicatedServerMeshLOD != INDEX_NONE)
+		{
+			SkeletalMesh->SetForcedLOD(FMath::Clamp(DedicatedServerMeshLOD, 0, SkeletalMesh->GetNumLODs() - 1) + 1);
+		}
+		SkeletalMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+		SkeletalMesh->KinematicBonesUpdateToPhysics = EKinematicBonesUpdateToPhysics::SkipAllBones;
+		SkeletalMesh->bDisableClothSimulation = true;
+	}
+
+	// Let the mesh skip frames on its own when it is off screen, significance decides how many
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+	DefaultVisibilityBasedAnimTickOption = GetMesh()->VisibilityBasedAnimTickOption;
+
+	AimCameraBlend->SetCamera(CameraBoom, FollowCamera);
+	AimCameraBlend->BlendAlpha = CameraMovementAlpha;
+	AimCameraBlend->SnapTo(GetCameraPose(false));
+
+	// Clients keep what the server replicated, a late joiner can see an archer that is already dead
+	if (HasAuthority())
+	{
+		Health = MaxHealth;
+	}
+
+	// Hits can come before the weapon is out, dedicated servers play no animations
+	if (!IsNetMode(NM_DedicatedServer))
+	{
+		TArray<FSoftObjectPath> HitContent;
+		HitReactionAnimations.GetPaths(HitContent);
+		DeathAnimations.GetPaths(HitContent);
+		if (HitContent.Num() > 0)
+		{
+			HitContentHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(HitContent);
+		}
+	}
+
+	ArcherSignificance::Register(this);
+
+	UArcherSpatialIndexSubsystem* SpatialIndex = UArcherWorldSubsystem::Get<UArcherSpatialIndexSubsystem>(this);
+	if (SpatialIndex != NULL && !bIsDead)
+	{
+		SpatialIndex->Register(this);
+	}
+}
+
+void AArcherCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ArcherSignificance::Unregister(this);
+
+	if (UArcherSpatialIndexSubsystem* SpatialIndex = UArcherWorldSubsystem::Get<UArcherSpatialIndexSubsystem>(this))
+	{
+		SpatialIndex->Unregister(this);
+	}
+
+	if (WeaponContentHandle.IsValid())
+	{
+		WeaponContentHandle->CancelHandle();
+		WeaponContentHandle.Reset();
+	}
+	if (HitContentHandle.IsValid())
+	{
+		HitContentHandle->CancelHandle();
+		HitContentHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AArcherCharacter::Restart()
+{
+	Super::Restart();
 
-	BowGripOffset->AttachToComponent(GetMesh(), FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("LeftHandGripPoint"));
+	// Only the locally controlled archer looks through its camera, possession is not known yet in BeginPlay
+	if (CameraBoom != NULL)
+	{
+		CameraBoom->SetComponentTickEnabled(IsLocallyControlled() && IsPlayerControlled());
+	}
+}
+
+void AArcherCharacter::ApplySignificance(EArcherSignificance NewSignificance)
+{
+	Significance = NewSignificance;
+
+	const UArcherSignificanceSettings* Settings = GetDefault<UArcherSignificanceSettings>();
+	const int32 Index = int32(NewSignificance);
+
+	if (Settings->AnimationTickIntervals.IsValidIndex(Index))
+	{
+		GetMesh()->SetComponentTickInterval(Settings->AnimationTickIntervals[Index]);
+	}
+	GetMesh()->VisibilityBasedAnimTickOption = NewSignificance == EArcherSignificance::Minimal
+		? EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered
+		: DefaultVisibilityBasedAnimTickOption.GetValue();
+
+	// Local player movement drives prediction and must stay per frame, bots can be throttled like anyone else
+	if (!(IsLocallyControlled() && IsPlayerControlled()) && Settings->MovementTickIntervals.IsValidIndex(Index))
+	{
+		GetCharacterMovement()->SetComponentTickInterval(Settings->MovementTickIntervals[Index]);
+	}
+
+	if (CameraBoom != NULL)
+	{
+		CameraBoom->SetComponentTickEnabled(IsLocallyControlled() && IsPlayerControlled());
+	}
 }
 
 
@@ -161,96 +358,673 @@ void AArcherCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerIn
 }
 
 
+void AArcherCharacter::ApplyInputFrame(const FArcherInputFrame& Frame)
+{
+	// Rotation the previous frame left, timed shots are released between it and this frame's
+	FRotator PreviousRotation = Frame.GetControlRotation();
+	if (Controller != NULL)
+	{
+		PreviousRotation = Controller->GetControlRotation();
+		Controller->SetControlRotation(Frame.GetControlRotation());
+	}
+
+	// Presses before releases so a tap within one frame still happens
+	if (Frame.WasPressed(EArcherInputAction::EquipWeapon))
+	{
+		EquipWeapon();
+	}
+	if (Frame.WasPressed(EArcherInputAction::WalkMode))
+	{
+		ToggleWalkMode();
+	}
+	if (Frame.WasPressed(EArcherInputAction::Sprint))
+	{
+		Sprint();
+	}
+	if (Frame.WasPressed(EArcherInputAction::Jump))
+	{
+		Jump();
+	}
+	if (Frame.WasPressed(EArcherInputAction::Aim))
+	{
+		Aim();
+	}
+	if (Frame.WasPressed(EArcherInputAction::Shoot))
+	{
+		if (!Frame.IsShotTimed())
+		{
+			Shoot();
+		}
+		else if (bIsAiming)
+		{
+			ReleaseArrow(FMath::Lerp(PreviousRotation, Frame.GetControlRotation(), Frame.GetShotAlpha()), Frame.GetShotTimeAhead());
+		}
+	}
+
+	MoveForward(Frame.GetMoveForward());
+	MoveRight(Frame.GetMoveRight());
+
+	if (Frame.WasReleased(EArcherInputAction::Sprint))
+	{
+		StopSprinting();
+	}
+	if (Frame.WasReleased(EArcherInputAction::Jump))
+	{
+		StopJumping();
+	}
+	if (Frame.WasReleased(EArcherInputAction::Aim))
+	{
+		StopAiming();
+	}
+}
+
 void AArcherCharacter::EquipWeapon()
 {
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherEquipWeapon);
+
+	if (!HasAuthority() && IsLocallyControlled())
+	{
+		ServerSetWeaponEquipped(!bIsWeaponEquipped);
+	}
+
 	if (!bIsWeaponEquipped)
 	{
-		if (PlayMontageAnimation(EquipWeaponMontage, false))
+		// Weapon comes out once its content has streamed in, see OnWeaponContentLoaded()
+		if (!WeaponContentHandle.IsValid() || !WeaponContentHandle->HasLoadCompleted())
 		{
-			bIsWeaponEquipped = true;			
-		}		
+			bEquipWhenLoaded = true;
+			PreloadWeaponContent();
+			return;
+		}
+		FinishEquipWeapon();
+	}
+	else if (!CanPlayWeaponMontages())
+	{
+		bIsWeaponEquipped = false;
+		ReleaseWeaponContent();
+		SetWeaponComponentActive(WeaponMesh, false);
 	}
 	else if (bIsWeaponEquipped)
 	{		
-		if (PlayMontageAnimation(DisarmWeaponMontage, false))
+		if (PlayMontageAnimation(DisarmWeaponMontage.Get(), false))
 		{
 			bIsWeaponEquipped = false;			
+			ReleaseWeaponContent();
+
+			// Bow stays in hand until the montage puts it away
+			FOnMontageEnded DisarmEnded = FOnMontageEnded::CreateUObject(this, &AArcherCharacter::OnDisarmMontageEnded);
+			GetMesh()->GetAnimInstance()->Montage_SetEndDelegate(DisarmEnded, DisarmWeaponMontage.Get());
 		}				
 	}	
 }
 
-void AArcherCharacter::Shoot()
+void AArcherCharacter::FinishEquipWeapon()
 {
-	if (bIsAiming && bIsArrowLoaded && ProjectileClass != NULL)
+	if (!CanPlayWeaponMontages() || PlayMontageAnimation(EquipWeaponMontage.Get(), false))
 	{
-		UWorld* const World = GetWorld();
-		if (World != NULL)
+		bIsWeaponEquipped = true;			
+		SetWeaponComponentActive(WeaponMesh, true);
+	}		
+}
+
+void AArcherCharacter::OnDisarmMontageEnded(UAnimMontage* Montage, bool bInterrupted)
+{
+	// Weapon may have been taken out again before the disarm montage was over
+	if (!bIsWeaponEquipped)
+	{
+		SetWeaponComponentActive(WeaponMesh, false);
+	}
+}
+
+bool AArcherCharacter::CanPlayWeaponMontages() const
+{
+	return !IsNetMode(NM_DedicatedServer) && GetMesh()->GetAnimInstance() != NULL;
+}
+
+void AArcherCharacter::OnUnanimatedNockTimer()
+{
+	if (bIsAiming && bIsWeaponEquipped)
+	{
+		SetArrowLoaded(true);
+	}
+}
+
+void AArcherCharacter::SetWeaponComponentActive(UStaticMeshComponent* Component, bool bActive)
+{
+	if (Component == NULL)
+	{
+		return;
+	}
+
+	if (bActive)
+	{
+		if (!Component->IsRegistered())
 		{
-			FActorSpawnParameters SpawnParams;
-			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+			Component->RegisterComponent();
+		}
+		Component->SetHiddenInGame(false, true);
+	}
+	else
+	{
+		Component->SetHiddenInGame(true, true);
+		if (Component->IsRegistered())
+		{
+			Component->UnregisterComponent();
+		}
+	}
+}
 
-			FRotator SpawnRotation = Controller->GetControlRotation();
-			FVector SpawnLocation = ProjectileReleasePoint->GetComponentLocation();
+FVector AArcherCharacter::GetProjectileReleaseLocation() const
+{
+	const FTransform WeaponTransform = WeaponSocketOffset * GetMesh()->GetSocketTransform(WeaponSocketName);
+	return WeaponTransform.TransformPosition(ProjectileReleaseOffset);
+}
 
-			World->SpawnActor<AProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, SpawnParams);			
+TSubclassOf<AProjectile> AArcherCharacter::GetProjectileClass() const
+{
+	return ProjectileClass.Get();
+}
 
-			ProjectileMesh->SetHiddenInGame(true, true);
-			bIsArrowLoaded = false;
+void AArcherCharacter::PreloadWeaponContent()
+{
+	if (WeaponContentHandle.IsValid())
+	{
+		return;
+	}
 
-			ProjectileMesh->SetRelativeLocationAndRotation(FVector(0.0f, 0.0f, 0.0f), FRotator(0.0f, 0.0f, 0.0f));
-		}		
+	TArray<FSoftObjectPath> Content;
+	Content.Add(ProjectileClass.ToSoftObjectPath());
+	// Dedicated server plays no montages
+	if (!IsNetMode(NM_DedicatedServer))
+	{
+		Content.Add(EquipWeaponMontage.ToSoftObjectPath());
+		Content.Add(DisarmWeaponMontage.ToSoftObjectPath());
+		Content.Add(DrawArrowMontage.ToSoftObjectPath());
+		Content.Add(DrawArrowLoopSectionMontage.ToSoftObjectPath());
+	}
+	Content.RemoveAll([](const FSoftObjectPath& Path) { return Path.IsNull(); });
+
+	if (Content.Num() == 0)
+	{
+		OnWeaponContentLoaded();
+		return;
+	}
+	WeaponContentHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Content, FStreamableDelegate::CreateUObject(this, &AArcherCharacter::OnWeaponContentLoaded));
+}
+
+bool AArcherCharacter::IsWeaponContentLoaded() const
+{
+	return (ProjectileClass.IsNull() || ProjectileClass.Get() != NULL)
+		&& (EquipWeaponMontage.IsNull() || EquipWeaponMontage.Get() != NULL)
+		&& (DisarmWeaponMontage.IsNull() || DisarmWeaponMontage.Get() != NULL)
+		&& (DrawArrowMontage.IsNull() || DrawArrowMontage.Get() != NULL)
+		&& (DrawArrowLoopSectionMontage.IsNull() || DrawArrowLoopSectionMontage.Get() != NULL);
+}
+
+void AArcherCharacter::OnWeaponContentLoaded()
+{
+	// Spawn arrows up front so the first shots don't hitch
+	if (UArrowPoolSubsystem* ArrowPool = UArcherWorldSubsystem::Get<UArrowPoolSubsystem>(this))
+	{
+		ArrowPool->Prewarm(GetProjectileClass());
+	}
+
+	if (bEquipWhenLoaded)
+	{
+		bEquipWhenLoaded = false;
+		FinishEquipWeapon();
+	}
+}
+
+void AArcherCharacter::ReleaseWeaponContent()
+{
+	// Servers keep the projectile class for everybody's shots
+	if (IsNetMode(NM_DedicatedServer) || IsNetMode(NM_ListenServer))
+	{
+		return;
+	}
+
+	if (WeaponContentHandle.IsValid())
+	{
+		WeaponContentHandle->ReleaseHandle();
+		WeaponContentHandle.Reset();
+	}
+}
+
+void AArcherCharacter::Shoot()
+{
+	if (bIsAiming && bIsArrowLoaded && GetProjectileClass() != NULL)
+	{
+		// Local player shots wait for the frame's look input, so they go where the player looked when clicking
+		AArcherPlayerController* PlayerController = Cast<AArcherPlayerController>(Controller);
+		if (PlayerController != NULL && PlayerController->DeferShot())
+		{
+			return;
+		}
+
+		ReleaseArrow(Controller->GetControlRotation(), 0.0f);
 	}	
 }
 
-void AArcherCharacter::ToggleWalkMode()
+void AArcherCharacter::ReleaseArrow(const FRotator& Rotation, float TimeAhead)
 {
-	if (!bWalkModeActive)
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherShoot);
+
+	UWorld* const World = GetWorld();
+	if (World == NULL || !bIsArrowLoaded || GetProjectileClass() == NULL)
 	{
-		bWalkModeActive = true;
-		GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
-		bIsSprintingAllowed = false;
+		return;
 	}
-	else if (bWalkModeActive)
+
+	const AGameStateBase* GameState = World->GetGameState();
+	const float ServerTime = GameState != NULL ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+
+	FArcherShot Shot;
+	Shot.Origin = GetProjectileReleaseLocation();
+	Shot.SetRotation(Rotation);
+	Shot.SetDrawStrength(GetDrawStrengthAt(World->GetTimeSeconds() - TimeAhead));
+	// Server rewinds to the release, not to the frame that got around to sending it
+	Shot.Timestamp = ServerTime - TimeAhead;
+	Shot.ShotId = NextShotId++;
+
+	FireShot(Shot, TimeAhead);
+
+	SetArrowLoaded(false);
+	if (ProjectileMesh != NULL)
 	{
-		bWalkModeActive = false;
-		GetCharacterMovement()->MaxWalkSpeed = RunSpeed;
-		bIsSprintingAllowed = true;
+		ProjectileMesh->SetRelativeLocationAndRotation(FVector(0.0f, 0.0f, 0.0f), FRotator(0.0f, 0.0f, 0.0f));
 	}
 }
 
-void AArcherCharacter::Sprint()
+float AArcherCharacter::GetDrawStrength() const
+{
+	return GetDrawStrengthAt(GetWorld()->GetTimeSeconds());
+}
+
+float AArcherCharacter::GetDrawStrengthAt(float Time) const
+{
+	if (FullDrawTime <= 0.0f)
+	{
+		return 1.0f;
+	}
+	const float DrawTime = FMath::Max(Time - ArrowLoadedTime, 0.0f);
+	return FMath::Lerp(MinDrawStrength, 1.0f, FMath::Min(DrawTime / FullDrawTime, 1.0f));
+}
+
+bool AArcherCharacter::GetAimPreview(TArray<FVector>& OutPath, FVector& OutImpactPoint)
+{
+	const TSubclassOf<AProjectile> LoadedProjectileClass = GetProjectileClass();
+	if (Controller == NULL || LoadedProjectileClass == NULL)
+	{
+		OutPath.Reset();
+		OutImpactPoint = FVector::ZeroVector;
+		return false;
+	}
+
+	const FArcherBallisticParams Params = FArcherBallisticParams::FromProjectileClass(LoadedProjectileClass, GetWorld(), GetDrawStrength());
+	const FArcherTrajectory& Trajectory = AimPreviewCache.Update(GetWorld(), Params, GetProjectileReleaseLocation(), Controller->GetControlRotation(), this);
+
+	OutPath = Trajectory.Path;
+	OutImpactPoint = Trajectory.GetEndPoint();
+	return Trajectory.bHit;
+}
+
+AProjectile* AArcherCharacter::LaunchProjectile(const FVector& Location, const FRotator& Rotation, float SpeedScale, float TimeAhead, bool bCosmetic, float ShotLatency)
 {
-	if (bIsSprintingAllowed)
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherLaunchProjectile);
+
+	UWorld* const World = GetWorld();
+	const TSubclassOf<AProjectile> LoadedProjectileClass = GetProjectileClass();
+	if (World == NULL || LoadedProjectileClass == NULL)
 	{
-		if (!bWalkModeActive)
+		return NULL;
+	}
+
+	// Batched arrows have no actor until they land
+	if (LoadedProjectileClass->GetDefaultObject<AProjectile>()->SimulationMode == EArrowSimulationMode::Batched)
+	{
+		if (AArrowSimulationManager* SimulationManager = AArrowSimulationManager::Get(this))
 		{
-			GetCharacterMovement()->MaxWalkSpeed = SprintSpeed;
-			GetCharacterMovement()->JumpZVelocity = JumpSprintZVelocity;			
+			SimulationManager->LaunchArrow(LoadedProjectileClass, Location, Rotation, this, SpeedScale, TimeAhead, bCosmetic, ShotLatency);
+			return NULL;
 		}
-		else if (bWalkModeActive)
+	}
+
+	// Reuse pooled arrow if possible, spawning a new actor for every shot causes hitches and GC spikes
+	AProjectile* Projectile = NULL;
+	UArrowPoolSubsystem* ArrowPool = UArcherWorldSubsystem::Get<UArrowPoolSubsystem>(this);
+	if (ArrowPool != NULL)
+	{
+		Projectile = ArrowPool->Acquire(LoadedProjectileClass, Location, Rotation, this);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+
+		Projectile = World->SpawnActor<AProjectile>(LoadedProjectileClass, Location, Rotation, SpawnParams);
+	}
+
+	if (Projectile != NULL && SpeedScale != 1.0f)
+	{
+		Projectile->GetProjectileMovement()->Velocity *= SpeedScale;
+		Projectile->GetProjectileMovement()->UpdateComponentVelocity();
+	}
+
+	// Before the catch up step below, it already has to hit the way the shot is meant to
+	if (Projectile != NULL)
+	{
+		Projectile->SetCosmetic(bCosmetic);
+		if (ShotLatency > 0.0f)
 		{
-			GetCharacterMovement()->MaxWalkSpeed = RunSpeed;
-			GetCharacterMovement()->JumpZVelocity = JumpRunZVelocity;
+			Projectile->SetShotLatency(ShotLatency);
 		}
 	}
+
+	// Released earlier in the frame, catch the arrow up with a movement step of its own, sweeping for hits on the way
+	if (Projectile != NULL && TimeAhead > 0.0f)
+	{
+		Projectile->GetProjectileMovement()->TickComponent(TimeAhead, LEVELTICK_All, NULL);
+	}
+	return Projectile;
 }
 
-void AArcherCharacter::StopSprinting()
+void AArcherCharacter::FireShot(const FArcherShot& Shot, float TimeAhead)
+{
+	if (HasAuthority())
+	{
+		LaunchShot(Shot, false, TimeAhead);
+		if (GetNetMode() != NM_Standalone)
+		{
+			MulticastFire(Shot);
+		}
+		return;
+	}
+
+	// Show the arrow right away, the server fires the real one from the same quantized shot
+	AProjectile* PredictedArrow = LaunchShot(Shot, true, TimeAhead);
+	PendingShots.Add(Shot.ShotId, PredictedArrow);
+	ServerFire(Shot);
+}
+
+AProjectile* AArcherCharacter::LaunchShot(const FArcherShot& Shot, bool bCosmetic, float TimeAhead, float ShotLatency)
+{
+	return LaunchProjectile(Shot.Origin, Shot.GetRotation(), Shot.GetDrawStrength(), TimeAhead, bCosmetic, ShotLatency);
+}
+
+bool AArcherCharacter::ServerFire_Validate(const FArcherShot& Shot)
+{
+	// Implausible shots are rejected in ServerFire_Implementation, lag can produce them and must not kick the player
+	return true;
+}
+
+void AArcherCharacter::ServerFire_Implementation(const FArcherShot& Shot)
+{
+	UWorld* const World = GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+	const float ServerTime = GameState != NULL ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+
+	// Equip and aim reach the server ahead of the shot, see ServerSetWeaponEquipped() and ServerSetAiming()
+	const bool bAccepted = GetProjectileClass() != NULL && bIsWeaponEquipped && bIsAiming
+		&& FVector::DistSquared(Shot.Origin, GetActorLocation()) <= FMath::Square(MaxShotOriginError)
+		&& ServerTime - LastServerShotTime >= MinShotInterval;
+
+	if (bAccepted)
+	{
+		LastServerShotTime = ServerTime;
+
+		// Shooter saw the world this long ago, no point rewinding past recorded history. Batched arrows keep it too
+		const float ShotLatency = FMath::Clamp(ServerTime - Shot.Timestamp, 0.0f, LagCompensation->GetRecordedDuration());
+
+		// No stronger than the server saw the arrow drawn. Its nock started when the aim arrived, one latency after the client's
+		FArcherShot ServerShot = Shot;
+		const float MaxDrawStrength = bIsArrowLoaded ? GetDrawStrengthAt(FMath::Min(Shot.Timestamp + ShotLatency, ServerTime)) : MinDrawStrength;
+		ServerShot.SetDrawStrength(FMath::Min(Shot.GetDrawStrength(), MaxDrawStrength));
+
+		LaunchShot(ServerShot, false, 0.0f, ShotLatency);
+		MulticastFire(ServerShot);
+
+		// Released like on the client, the next shot is drawn from scratch
+		SetArrowLoaded(false);
+		if (bIsAiming && !CanPlayWeaponMontages())
+		{
+			GetWorldTimerManager().SetTimer(UnanimatedNockTimer, this, &AArcherCharacter::OnUnanimatedNockTimer, FMath::Max(UnanimatedNockTime, KINDA_SMALL_NUMBER));
+		}
+	}
+
+	ClientConfirmShot(Shot.ShotId, bAccepted);
+}
+
+bool AArcherCharacter::ServerSetWeaponEquipped_Validate(bool bEquipped)
+{
+	return true;
+}
+
+void AArcherCharacter::ServerSetWeaponEquipped_Implementation(bool bEquipped)
 {
-	if (!bWalkModeActive)
+	if (bEquipped != bIsWeaponEquipped)
 	{
-		GetCharacterMovement()->MaxWalkSpeed = RunSpeed;
-		GetCharacterMovement()->JumpZVelocity = JumpRunZVelocity;		
+		EquipWeapon();
 	}
-	else if (bWalkModeActive)
+}
+
+bool AArcherCharacter::ServerSetAiming_Validate(bool bAiming)
+{
+	return true;
+}
+
+void AArcherCharacter::ServerSetAiming_Implementation(bool bAiming)
+{
+	if (bAiming)
+	{
+		Aim();
+	}
+	else
 	{
-		GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
-		GetCharacterMovement()->JumpZVelocity = JumpWalkZVelocity;		
+		StopAiming();
 	}
 }
 
+void AArcherCharacter::ClientConfirmShot_Implementation(uint8 ShotId, bool bAccepted)
+{
+	TWeakObjectPtr<AProjectile> PredictedArrow;
+	PendingShots.RemoveAndCopyValue(ShotId, PredictedArrow);
+
+	// Server never fired this arrow, take back the one the player saw
+	if (!bAccepted && PredictedArrow.IsValid() && !PredictedArrow->IsInPool() && PredictedArrow->IsCosmetic())
+	{
+		PredictedArrow->ReleaseProjectile();
+	}
+}
+
+void AArcherCharacter::MulticastFire_Implementation(const FArcherShot& Shot)
+{
+	// Owner already shows its predicted arrow and the server its real one, replicated arrow classes arrive as actors
+	if (IsLocallyControlled() || HasAuthority())
+	{
+		return;
+	}
+
+	// Shot is cosmetic here, skip it rather than hitch on a synchronous load
+	const TSubclassOf<AProjectile> LoadedProjectileClass = GetProjectileClass();
+	if (LoadedProjectileClass == NULL)
+	{
+		PreloadWeaponContent();
+		return;
+	}
+	if (LoadedProjectileClass->GetDefaultObject<AProjectile>()->GetIsReplicated())
+	{
+		return;
+	}
+
+	LaunchShot(Shot, true);
+}
+
+void AArcherCharacter::ApplyImpacts(const FArcherImpactSummary& Summary)
+{
+	if (!IsAlive() || Summary.NumHits == 0)
+	{
+		return;
+	}
+
+	const float NewHealth = FMath::Max(Health - Summary.TotalDamage, 0.0f);
+	UE_LOG(LogArcher, Verbose, TEXT("%s took %d hits for %.1f damage from %s, %.1f health left"), *GetName(), Summary.NumHits, Summary.TotalDamage, *GetNameSafe(Summary.Instigator), NewHealth);
+
+	Health = NewHealth;
+	const bool bKilled = !IsAlive();
+
+	// Rep notifies don't run on the server
+	if (bKilled)
+	{
+		Die();
+	}
+
+	MulticastImpacts(uint8(FMath::Min(Summary.NumHits, int32(MAX_uint8))), Summary.TotalDamage, bKilled, Summary.Direction);
+}
+
+void AArcherCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AArcherCharacter, Health);
+}
+
+void AArcherCharacter::OnRep_Health()
+{
+	if (!IsAlive())
+	{
+		Die();
+	}
+}
+
+void AArcherCharacter::MulticastImpacts_Implementation(uint8 NumHits, float Damage, bool bKilled, FVector_NetQuantizeNormal Direction)
+{
+	// Late reaction to a hit taken before the killing one
+	if (bIsDead && !bKilled)
+	{
+		return;
+	}
+
+	// Far away archers that aren't rendered skip the reaction, deaths always show
+	if (!IsNetMode(NM_DedicatedServer) && (bKilled || Significance != EArcherSignificance::Minimal))
+	{
+		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+		const FVector LocalDirection = GetActorTransform().InverseTransformVectorNoScale(-Direction);
+		UAnimSequenceBase* Animation = bKilled ? DeathAnimations.Pick(LocalDirection) : HitReactionAnimations.Pick(LocalDirection);
+		if (AnimInstance != NULL && Animation != NULL)
+		{
+			UAnimMontage* Montage = AnimInstance->PlaySlotAnimationAsDynamicMontage(Animation, HitAnimationSlot, 0.1f, 0.2f);
+			if (Montage != NULL && bKilled)
+			{
+				Montage->bEnableAutoBlendOut = false;
+			}
+		}
+	}
+
+	OnImpacts.Broadcast(this, NumHits, Damage);
+}
+
+void AArcherCharacter::Die()
+{
+	if (bIsDead)
+	{
+		return;
+	}
+	bIsDead = true;
+
+	bIsAiming = false;
+	GetArcherMovement()->bWantsToAim = false;
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	if (UArcherSpatialIndexSubsystem* SpatialIndex = UArcherWorldSubsystem::Get<UArcherSpatialIndexSubsystem>(this))
+	{
+		SpatialIndex->Unregister(this);
+	}
+
+	// Bots stop thinking and players lose control of the body
+	if (HasAuthority())
+	{
+		DetachFromControllerPendingDestroy();
+	}
+}
+
+void AArcherCharacter::SetArrowLoaded(bool bLoaded)
+{
+	bIsArrowLoaded = bLoaded;
+	if (bLoaded)
+	{
+		ArrowLoadedTime = GetWorld()->GetTimeSeconds();
+	}
+	SetWeaponComponentActive(ProjectileMesh, bLoaded);
+}
+
+void AArcherCharacter::ToggleWalkMode()
+{
+	UArcherMovementComponent* ArcherMovement = GetArcherMovement();
+	ArcherMovement->bWantsToWalk = !ArcherMovement->bWantsToWalk;
+}
+
+void AArcherCharacter::Sprint()
+{
+	GetArcherMovement()->bWantsToSprint = true;
+}
+
+void AArcherCharacter::StopSprinting()
+{
+	GetArcherMovement()->bWantsToSprint = false;
+}
+
+UArcherMovementComponent* AArcherCharacter::GetArcherMovement() const
+{
+	return CastChecked<UArcherMovementComponent>(GetCharacterMovement());
+}
+
+float AArcherCharacter::GetRunSpeed() const
+{
+	return GetArcherMovement()->RunSpeed;
+}
+
+float AArcherCharacter::GetSprintSpeed() const
+{
+	return GetArcherMovement()->SprintSpeed;
+}
+
+float AArcherCharacter::GetSprintSpeedCrouched() const
+{
+	return GetArcherMovement()->SprintSpeedCrouched;
+}
+
+float AArcherCharacter::GetWalkSpeed() const
+{
+	return GetArcherMovement()->WalkSpeed;
+}
+
+float AArcherCharacter::GetWalkSpeedCrouched() const
+{
+	return GetArcherMovement()->WalkSpeedCrouched;
+}
+
+float AArcherCharacter::GetJumpWalkZVelocity() const
+{
+	return GetArcherMovement()->JumpWalkZVelocity;
+}
+
+float AArcherCharacter::GetJumpRunZVelocity() const
+{
+	return GetArcherMovement()->JumpRunZVelocity;
+}
+
+float AArcherCharacter::GetJumpSprintZVelocity() const
+{
+	return GetArcherMovement()->JumpSprintZVelocity;
+}
+
 bool AArcherCharacter::PlayMontageAnimation(UAnimMontage* AnimationToPlay, const bool bPlayInReverse)
 {
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherPlayMontageAnimation);
+
 	// try to play arraw drawing animation if specified
 	if (AnimationToPlay != NULL)
 	{		
@@ -271,53 +1045,76 @@ bool AArcherCharacter::PlayMontageAnimation(UAnimMontage* AnimationToPlay, const
 	return false;	
 }
 
+FAimCameraPose AArcherCharacter::GetCameraPose(bool bAimMode) const
+{
+	FAimCameraPose Pose;
+	Pose.TargetArmLength = bAimMode ? AimModeTargetArmLength : DefaultTargetArmLength;
+	Pose.FieldOfView = bAimMode ? AimModeFieldOfView : DefaultFieldOfView;
+	Pose.SocketOffsetY = bAimMode ? AimModeCameraBoomSocketOffsetY : DefaultCameraBoomSocketOffsetY;
+	return Pose;
+}
 
-// Help to return to walk mode that was set befor aim function.
-bool bWasWalkModeChanged = false;
 void AArcherCharacter::Aim()
 {	
-	if (bIsWeaponEquipped && ProjectileClass != NULL)
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherAim);
+
+	if (!HasAuthority() && IsLocallyControlled())
+	{
+		ServerSetAiming(true);
+	}
+
+	if (bIsWeaponEquipped && GetProjectileClass() != NULL)
 	{
 		bIsAiming = true;
+		AimCameraBlend->BlendTo(GetCameraPose(true));
 
-		// Adjust movement settings while aiming
-		GetCharacterMovement()->SetJumpAllowed(false);
-		if (!bWalkModeActive)
-		{
-			ToggleWalkMode();
-			bWasWalkModeChanged = true;
-		}
+		// Walk and don't jump while aiming, resolved by the movement component on client and server alike
+		GetArcherMovement()->bWantsToAim = true;
 
 		// Play Drawing arrow animation if needed
-		if (!bIsArrowLoaded)
+		if (!bIsArrowLoaded && !CanPlayWeaponMontages())
 		{
-			/**bIsArrowLoaded will be change to true (in BP animinstance) after draw arrow montage was played (notify) */
-			PlayMontageAnimation(DrawArrowMontage, false);
+			GetWorldTimerManager().SetTimer(UnanimatedNockTimer, this, &AArcherCharacter::OnUnanimatedNockTimer, FMath::Max(UnanimatedNockTime, KINDA_SMALL_NUMBER));
+		}
+		else if (!bIsArrowLoaded)
+		{
+			/**bIsArrowLoaded will be change to true (ArrowLoaded notify in UArcherAnimInstance) after draw arrow montage was played */
+			PlayMontageAnimation(DrawArrowMontage.Get(), false);
 		}
 	}	
 }
 
 void AArcherCharacter::StopAiming()
 {
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherStopAiming);
+
+	if (!HasAuthority() && IsLocallyControlled())
+	{
+		ServerSetAiming(false);
+	}
+
 	bIsAiming = false;
+	AimCameraBlend->BlendTo(GetCameraPose(false));
 
-	// Set movement settings back to normal
-	GetCharacterMovement()->SetJumpAllowed(true);
-	if (bWasWalkModeChanged)
+	// Set movement settings back to normal, walk mode toggled before aiming stays on
+	GetArcherMovement()->bWantsToAim = false;
+
+	if (!CanPlayWeaponMontages())
 	{
-		ToggleWalkMode();
-		bWasWalkModeChanged = false;
-	}		
+		GetWorldTimerManager().ClearTimer(UnanimatedNockTimer);
+		SetArrowLoaded(false);
+		return;
+	}
 
 	// Play Drawing arrow animation if needed
 	if (bIsArrowLoaded && bIsWeaponEquipped)
 	{
-		/**bIsArrowLoaded will be change to false (in BP animinstance) after draw arrow montage was played (notify) */
-		PlayMontageAnimation(DrawArrowMontage, true);
+		/**bIsArrowLoaded will be change to false (ArrowUnloaded notify in UArcherAnimInstance) after draw arrow montage was played */
+		PlayMontageAnimation(DrawArrowMontage.Get(), true);
 	}
 	else
 	{
-		PlayMontageAnimation(DrawArrowLoopSectionMontage, true);
+		PlayMontageAnimation(DrawArrowLoopSectionMontage.Get(), true);
 	}
 	// TODO Add timer to wait for animation to stop playing so that it bCanAim will be change back to true 
 }
@@ -351,6 +1148,8 @@ void AArcherCharacter::LookUpAtRate(float Rate)
 
 void AArcherCharacter::MoveForward(float Value)
 {
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherMoveInput);
+
 	if ((Controller != NULL) && (Value != 0.0f))
 	{
 		// find out which way is forward
@@ -365,6 +1164,8 @@ void AArcherCharacter::MoveForward(float Value)
 
 void AArcherCharacter::MoveRight(float Value)
 {
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherMoveInput);
+
 	if ( (Controller != NULL) && (Value != 0.0f) )
 	{
 		// find out which way is right
@@ -4,8 +4,38 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "ArcherSignificance.h"
+#include "ArcherShot.h"
+#include "ArcherBallistics.h"
+#include "Components/SkinnedMeshComponent.h"
 #include "ArcherCharacter.generated.h"
 
+/** Animation for each side an archer can be hit from */
+USTRUCT()
+struct FArcherDirectionalAnimations
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = Animation)
+	TSoftObjectPtr<class UAnimSequenceBase> Front;
+
+	UPROPERTY(EditAnywhere, Category = Animation)
+	TSoftObjectPtr<class UAnimSequenceBase> Back;
+
+	UPROPERTY(EditAnywhere, Category = Animation)
+	TSoftObjectPtr<class UAnimSequenceBase> Left;
+
+	UPROPERTY(EditAnywhere, Category = Animation)
+	TSoftObjectPtr<class UAnimSequenceBase> Right;
+
+	/** Animation for a hit coming from LocalDirection, in the archer's space. NULL if it is not loaded */
+	class UAnimSequenceBase* Pick(const FVector& LocalDirection) const;
+
+	void GetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FArcherImpactsSignature, class AArcherCharacter*, Archer, int32, NumHits, float, Damage);
+
 UCLASS(config=Game)
 class AArcherCharacter : public ACharacter
 {
@@ -19,29 +49,169 @@ class AArcherCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;		
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Projectile, meta = (AllowPrivateAccess = "true"))
-	class UStaticMeshComponent* ProjectileMesh;	
+	/** Server side hitbox history for validating arrow hits */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Network, meta = (AllowPrivateAccess = "true"))
+	class UArcherLagCompensationComponent* LagCompensation;
 
+	/** Zooms the camera in and out of aim mode */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
+	class UAimCameraBlendComponent* AimCameraBlend;
+
+	/** Arrow in the drawing hand, registered only while an arrow is nocked */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Projectile, meta = (AllowPrivateAccess = "true"))
-	class USceneComponent* ProjectileReleasePoint;
+	class UStaticMeshComponent* ProjectileMesh;	
 
+	/** Bow in the grip hand, registered only while the weapon is out */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon, meta = (AllowPrivateAccess = "true"))
 	class UStaticMeshComponent* WeaponMesh;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon, meta = (AllowPrivateAccess = "true"))
-	class USceneComponent* BowGripOffset;
-
 public:
-	AArcherCharacter();	
+	AArcherCharacter(const FObjectInitializer& ObjectInitializer);	
 
 protected:
 	virtual void BeginPlay();
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void Restart() override;
 		
 public:
 
-	/** Projectile class to spawn */
+	/** Scale animation, movement and camera update rates to how much this archer matters to the local view */
+	void ApplySignificance(EArcherSignificance NewSignificance);
+
+	FORCEINLINE EArcherSignificance GetSignificance() const { return Significance; }
+
+	/** Projectile class to spawn, streamed in together with the weapon montages */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile)
+	TSoftClassPtr<class AProjectile> ProjectileClass;	
+
+	/** Returns ProjectileClass if it is loaded, NULL while it streams in */
+	TSubclassOf<class AProjectile> GetProjectileClass() const;
+
+	/**
+	 * Start streaming projectile class and weapon montages in the background, call when a weapon comes in reach.
+	 * Content stays resident while the weapon is equipped and is released when it is put away.
+	 */
+	UFUNCTION(BlueprintCallable, Category = Weapon)
+	void PreloadWeaponContent();
+
+	/** Returns true once projectile class and weapon montages are in memory */
+	UFUNCTION(BlueprintPure, Category = Weapon)
+	bool IsWeaponContentLoaded() const;
+
+	/** Mesh socket the bow is held by */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	FName WeaponSocketName;
+
+	/** Bow transform relative to WeaponSocketName */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Weapon)
+	FTransform WeaponSocketOffset;
+
+	/** Mesh socket the nocked arrow is held by */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	FName ProjectileSocketName;
+
+	/** Where arrows leave the bow, in bow space (WeaponSocketName socket plus WeaponSocketOffset) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	FVector ProjectileReleaseOffset;
+
+	/** World location arrows are released from, worked out from the posed mesh when asked for */
+	UFUNCTION(BlueprintPure, Category = Projectile)
+	FVector GetProjectileReleaseLocation() const;
+
+	/** Seconds the bow has to stay drawn for a full strength shot, 0 shoots at full strength right away */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile)
-	TSubclassOf<class AProjectile> ProjectileClass;	
+	float FullDrawTime;
+
+	/** Draw strength of a shot released as soon as the arrow is loaded */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile, meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float MinDrawStrength;
+
+	/** Strength of a shot released now, grows from MinDrawStrength to 1 over FullDrawTime after the arrow is nocked */
+	UFUNCTION(BlueprintPure, Category = Projectile)
+	float GetDrawStrength() const;
+
+	/**
+	 * Where a shot released now would fly, for drawing the aim arc. Predicted again only when the aim moves
+	 * @param OutPath - arrow positions along the flight
+	 * @param OutImpactPoint - where the arrow hits, or where prediction gave up
+	 * @return true if the arrow hits something
+	 */
+	UFUNCTION(BlueprintCallable, Category = Projectile)
+	bool GetAimPreview(TArray<FVector>& OutPath, FVector& OutImpactPoint);
+
+	/** Server rejects shots whose origin is further than this from the archer */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile|Network")
+	float MaxShotOriginError;
+
+	/**
+	 * Mesh LOD posed on dedicated servers, INDEX_NONE leaves the LOD alone.
+	 * Only pick a LOD whose bone reduction keeps the lag compensation hitbox bones and the hand grip sockets
+	 */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile|Network")
+	int32 DedicatedServerMeshLOD;
+
+	/** Server rejects shots fired faster than this, in seconds */
+	UPROPERTY(EditDefaultsOnly, Category = "Projectile|Network")
+	float MinShotInterval;
+
+	/**
+	 * Put a ProjectileClass arrow in flight, the way projectile class defaults ask for (pooled actor or batched simulation)
+	 * @param Location - world location the arrow starts from
+	 * @param Rotation - direction of flight
+	 * @param SpeedScale - fraction of the projectile class launch speed
+	 * @param TimeAhead - seconds the arrow has already been flying, it is moved on by that much right away
+	 * @param bCosmetic - arrow only stands in for a shot the server simulates, see AProjectile::SetCosmetic()
+	 * @param ShotLatency - seconds the shooter's view lagged behind the server, see AProjectile::SetShotLatency()
+	 * @return the arrow actor, or NULL when the arrow is simulated in a batch
+	 */
+	class AProjectile* LaunchProjectile(const FVector& Location, const FRotator& Rotation, float SpeedScale = 1.0f, float TimeAhead = 0.0f, bool bCosmetic = false, float ShotLatency = 0.0f);
+
+	/**
+	 * Let go of the nocked arrow, Shoot() input does so right away or through AArcherPlayerController::DeferShot()
+	 * @param Rotation - aim at the moment of release
+	 * @param TimeAhead - seconds since the release, the arrow starts that far along its flight and with the draw strength it had then
+	 */
+	void ReleaseArrow(const FRotator& Rotation, float TimeAhead);
+
+	/** Nock or put away the arrow, called from draw arrow montage notifies. The only way to change bIsArrowLoaded */
+	UFUNCTION(BlueprintCallable, Category = Character)
+	void SetArrowLoaded(bool bLoaded);
+
+	/** Health a fresh archer starts with */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Health)
+	float MaxHealth;
+
+	/** Health left, set by the server and replicated, clients kill the archer from OnRep_Health() */
+	UPROPERTY(ReplicatedUsing = OnRep_Health, BlueprintReadOnly, Category = Health)
+	float Health;
+
+	UFUNCTION(BlueprintPure, Category = Health)
+	bool IsAlive() const { return Health > 0.0f; }
+
+	/** Fired once per frame the archer was hit, with all hits of that frame. For UI and hit markers */
+	UPROPERTY(BlueprintAssignable, Category = Health)
+	FArcherImpactsSignature OnImpacts;
+
+	/** Played in HitAnimationSlot when hit and still alive */
+	UPROPERTY(EditDefaultsOnly, Category = "Character Hit Animations")
+	FArcherDirectionalAnimations HitReactionAnimations;
+
+	/** Played in HitAnimationSlot on the killing hit, the last frame is held */
+	UPROPERTY(EditDefaultsOnly, Category = "Character Hit Animations")
+	FArcherDirectionalAnimations DeathAnimations;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Character Hit Animations")
+	FName HitAnimationSlot;
+
+	/** Take the hits of a frame at once, called by UArcherImpactEventSubsystem on the authority */
+	void ApplyImpacts(const struct FArcherImpactSummary& Summary);
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Act on input the way the bindings of SetupPlayerInputComponent() do, used to replay recorded input */
+	void ApplyInputFrame(const struct FArcherInputFrame& Frame);
 
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
@@ -51,29 +221,57 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseLookUpRate;	
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float RunSpeed;
+	/**
+	 * Movement speeds and jump velocities live in UArcherMovementComponent.
+	 * These read through to it so blueprints made before the move, like Akai_Archer_Anim_BP, keep working
+	 */
+	UPROPERTY(BlueprintGetter = GetRunSpeed, Category = Character)
+	float RunSpeed;
+
+	UPROPERTY(BlueprintGetter = GetSprintSpeed, Category = Character)
+	float SprintSpeed;
+
+	UPROPERTY(BlueprintGetter = GetSprintSpeedCrouched, Category = Character)
+	float SprintSpeedCrouched;
+
+	UPROPERTY(BlueprintGetter = GetWalkSpeed, Category = Character)
+	float WalkSpeed;
+
+	UPROPERTY(BlueprintGetter = GetWalkSpeedCrouched, Category = Character)
+	float WalkSpeedCrouched;
+
+	UPROPERTY(BlueprintGetter = GetJumpWalkZVelocity, Category = Character)
+	float JumpWalkZVelocity;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float SprintSpeed;
+	UPROPERTY(BlueprintGetter = GetJumpRunZVelocity, Category = Character)
+	float JumpRunZVelocity;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float SprintSpeedCrouched;
+	UPROPERTY(BlueprintGetter = GetJumpSprintZVelocity, Category = Character)
+	float JumpSprintZVelocity;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float WalkSpeed;
+	UFUNCTION(BlueprintGetter)
+	float GetRunSpeed() const;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float WalkSpeedCrouched;	
+	UFUNCTION(BlueprintGetter)
+	float GetSprintSpeed() const;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float JumpWalkZVelocity;
+	UFUNCTION(BlueprintGetter)
+	float GetSprintSpeedCrouched() const;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float JumpRunZVelocity;
+	UFUNCTION(BlueprintGetter)
+	float GetWalkSpeed() const;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Character)
-		float JumpSprintZVelocity;
+	UFUNCTION(BlueprintGetter)
+	float GetWalkSpeedCrouched() const;
+
+	UFUNCTION(BlueprintGetter)
+	float GetJumpWalkZVelocity() const;
+
+	UFUNCTION(BlueprintGetter)
+	float GetJumpRunZVelocity() const;
+
+	UFUNCTION(BlueprintGetter)
+	float GetJumpSprintZVelocity() const;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Character)
 		bool bIsAiming;
@@ -84,7 +282,8 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Character)
 		bool bIsWeaponEquipped;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Character)
+	/** Set through SetArrowLoaded(), which also starts the draw and shows the arrow mesh */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Character)
 		bool bIsArrowLoaded;	
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Aim Camera / Smooth Zoom")
@@ -109,23 +308,96 @@ public:
 		float AimModeCameraBoomSocketOffsetY;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Montage Animations")
-		class UAnimMontage* DrawArrowLoopSectionMontage;
+		TSoftObjectPtr<class UAnimMontage> DrawArrowLoopSectionMontage;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Montage Animations")
-		class UAnimMontage* DrawArrowMontage;	
+		TSoftObjectPtr<class UAnimMontage> DrawArrowMontage;	
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Montage Animations")
-		class UAnimMontage* EquipWeaponMontage;
+		TSoftObjectPtr<class UAnimMontage> EquipWeaponMontage;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Montage Animations")
-		class UAnimMontage* DisarmWeaponMontage;
+		TSoftObjectPtr<class UAnimMontage> DisarmWeaponMontage;
+
+	/** Seconds from starting to aim until the arrow is nocked where no montages play, e.g. bots on a dedicated server */
+	UPROPERTY(EditDefaultsOnly, Category = "Character Montage Animations")
+		float UnanimatedNockTime;
 	
 
 protected:			
 
-	bool bWalkModeActive;	
-	
-	bool bIsSprintingAllowed;	
+	EArcherSignificance Significance;
+
+	/** Time the current arrow was nocked, draw strength grows from there */
+	float ArrowLoadedTime;
+
+	/** Strength of a shot released at world time Time, see GetDrawStrength() */
+	float GetDrawStrengthAt(float Time) const;
+
+	/** Last aim preview, see GetAimPreview() */
+	FArcherTrajectoryCache AimPreviewCache;
+
+	uint8 NextShotId;
+
+	/** Predicted arrows of shots the server has not answered yet, by shot id */
+	TMap<uint8, TWeakObjectPtr<class AProjectile>> PendingShots;
+
+	/** Server side, world time of the last accepted shot */
+	float LastServerShotTime;
+
+	/** Keeps weapon content resident while the weapon is in use */
+	TSharedPtr<struct FStreamableHandle> WeaponContentHandle;
+
+	/** EquipWeapon() was asked for before the content was loaded */
+	bool bEquipWhenLoaded;
+
+	/** Keeps hit reaction and death animations resident */
+	TSharedPtr<struct FStreamableHandle> HitContentHandle;
+
+	/** Set once Die() ran, health can be replicated and the killing hit multicast in either order */
+	bool bIsDead;
+
+	/** Reaction or death animation of a frame's hits on every machine, sent once per frame however many arrows hit.
+	 * Cosmetic only, Health and Die() get there through replication even when this is dropped */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastImpacts(uint8 NumHits, float Damage, bool bKilled, FVector_NetQuantizeNormal Direction);
+
+	UFUNCTION()
+	void OnRep_Health();
+
+	/** Stop moving and acting, leave the spatial index so nobody aims at the body. Does nothing when already dead */
+	void Die();
+
+	void OnWeaponContentLoaded();
+
+	/** Let weapon content go, it is unloaded by the next garbage collection unless something else uses it */
+	void ReleaseWeaponContent();
+
+	/** Play the equip montage and take the weapon out, content must be loaded */
+	void FinishEquipWeapon();
+
+	/** Put the bow away for good once the disarm montage is over */
+	void OnDisarmMontageEnded(class UAnimMontage* Montage, bool bInterrupted);
+
+	/**
+	 * False where weapon montages never play, dedicated servers load none and meshes without an anim instance can't.
+	 * Equipping and nocking happen without their montages and notifies there
+	 */
+	bool CanPlayWeaponMontages() const;
+
+	/** Nocks the arrow UnanimatedNockTime after aiming started when there is no draw montage to do it */
+	FTimerHandle UnanimatedNockTimer;
+
+	void OnUnanimatedNockTimer();
+
+	/**
+	 * Register and show a weapon mesh, or hide and unregister it.
+	 * Unregistered components are left out of transform updates when the archer moves or animates
+	 */
+	static void SetWeaponComponentActive(class UStaticMeshComponent* Component, bool bActive);
+
+	/** Mesh tick option set up by the blueprint, restored when the archer becomes significant again */
+	TEnumAsByte<EVisibilityBasedAnimTickOption::Type> DefaultVisibilityBasedAnimTickOption;
 
 	//** Attach and make visible mesh of a weapon to character*/
 	void EquipWeapon();
@@ -133,13 +405,13 @@ protected:
 	//** Spawn ProjectileClas, works only if bIsLoaded = true*/
 	void Shoot();
 	
-	//** Turn On/Off WalkMode (Change MaxWalkingSpeed) */
+	//** Turn On/Off WalkMode (UArcherMovementComponent uses WalkSpeed) */
 	void ToggleWalkMode();	
 
-	//** Change MaxWalkingSpeed of MovementComponent to SprintSpeed */
+	//** Start sprinting, ignored in walk mode and while aiming */
 	void Sprint();
 	
-	//** Depending on movement mode (run/walk) Change MaxWalkingSpeed of Movementcomponent */
+	//** Go back to run or walk speed, depending on walk mode */
 	void StopSprinting();
 
 	/**
@@ -149,6 +421,34 @@ protected:
 	 * @return true if animation was played correctly.
 	 */
 	bool PlayMontageAnimation(class UAnimMontage* AnimationToPlay, const bool bPlayInReverse);
+
+	/** Fire Shot on this machine and replicate it: predicted on owning clients, authoritative on the server */
+	void FireShot(const FArcherShot& Shot, float TimeAhead = 0.0f);
+
+	/** Launch the arrow described by Shot, cosmetic arrows only stand in for the server's one */
+	class AProjectile* LaunchShot(const FArcherShot& Shot, bool bCosmetic, float TimeAhead = 0.0f, float ShotLatency = 0.0f);
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerFire(const FArcherShot& Shot);
+
+	/** Equip or disarm on the server too, so it knows whether shots of this archer are possible */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSetWeaponEquipped(bool bEquipped);
+
+	/** Aim or stop aiming on the server too, it nocks and draws along to check the shots */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSetAiming(bool bAiming);
+
+	/** Tell the owning client whether its predicted shot was accepted */
+	UFUNCTION(Client, Reliable)
+	void ClientConfirmShot(uint8 ShotId, bool bAccepted);
+
+	/** Show an accepted shot on every other client */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastFire(const FArcherShot& Shot);
+
+	/** Camera settings for aim mode, or the default ones when bAimMode is false */
+	struct FAimCameraPose GetCameraPose(bool bAimMode) const;
 	
 	//** Change Field of View to zoom, UseControllerRotationPitch to true */
 	void Aim();
@@ -188,17 +488,19 @@ protected:
 	// End of APawn interface
 
 public:
+	/** Returns CharacterMovement subobject as archer movement **/
+	class UArcherMovementComponent* GetArcherMovement() const;
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns LagCompensation subobject **/
+	FORCEINLINE class UArcherLagCompensationComponent* GetLagCompensation() const { return LagCompensation; }
+	/** Returns AimCameraBlend subobject **/
+	FORCEINLINE class UAimCameraBlendComponent* GetAimCameraBlend() const { return AimCameraBlend; }
 	//** Returns ProjectileMesh subobject **/
 	FORCEINLINE class UStaticMeshComponent* GetProjectileMesh() const { return ProjectileMesh; }
-	//** Returns ProjectileReleasePoint subobject **/
-	FORCEINLINE	class USceneComponent* GetProjectileReleasePoint() const { return ProjectileReleasePoint; }
 	//** Returns WeaponMesh subobject **/
 	FORCEINLINE class  UStaticMeshComponent* GetWeaponMesh() const { return WeaponMesh; }
-	//** Returns BowGripOffset subobject**/
-	FORCEINLINE  class USceneComponent* GetBowGripOffset() const { return BowGripOffset; }	
 };
 
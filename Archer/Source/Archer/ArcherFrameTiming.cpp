@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherFrameTiming.h"
+#include "RenderCore.h"
+
+FArcherFrameTimings::FArcherFrameTimings()
+	: LastFrameTime(0.0)
+{
+}
+
+void FArcherFrameTimings::Start(int32 ExpectedFrames)
+{
+	Frames.Reset(ExpectedFrames);
+	LastFrameTime = FPlatformTime::Seconds();
+}
+
+const FArcherFrameTiming& FArcherFrameTimings::RecordFrame()
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FArcherFrameTiming& Timing = Frames.AddDefaulted_GetRef();
+	Timing.FrameMs = float((Now - LastFrameTime) * 1000.0);
+	// Game thread time of the last frame, kept by the engine for 'stat unit'
+	Timing.GameThreadMs = float(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	LastFrameTime = Now;
+	return Timing;
+}
+
+FString FArcherFrameTimings::ToCsv() const
+{
+	FString Csv = TEXT("Frame,FrameMs,GameThreadMs\n");
+	for (int32 Index = 0; Index < Frames.Num(); ++Index)
+	{
+		Csv += FString::Printf(TEXT("%d,%.3f,%.3f\n"), Index, Frames[Index].FrameMs, Frames[Index].GameThreadMs);
+	}
+	return Csv;
+}
+
+FArcherFrameTimeSummary FArcherFrameTimings::Summarize() const
+{
+	FArcherFrameTimeSummary Summary;
+	Summary.NumFrames = Frames.Num();
+	if (Frames.Num() == 0)
+	{
+		return Summary;
+	}
+
+	TArray<float> SortedFrameMs;
+	SortedFrameMs.Reserve(Frames.Num());
+	double TotalFrameMs = 0.0;
+	for (const FArcherFrameTiming& Timing : Frames)
+	{
+		SortedFrameMs.Add(Timing.FrameMs);
+		TotalFrameMs += Timing.FrameMs;
+	}
+	SortedFrameMs.Sort();
+
+	Summary.AverageMs = float(TotalFrameMs / SortedFrameMs.Num());
+	Summary.MedianMs = SortedFrameMs[SortedFrameMs.Num() / 2];
+	Summary.Percentile95Ms = SortedFrameMs[FMath::Min(SortedFrameMs.Num() * 95 / 100, SortedFrameMs.Num() - 1)];
+	Summary.MaxMs = SortedFrameMs.Last();
+	return Summary;
+}
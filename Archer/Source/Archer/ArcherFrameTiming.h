@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Real time and game thread time of one frame */
+struct ARCHER_API FArcherFrameTiming
+{
+	float FrameMs;
+	float GameThreadMs;
+};
+
+/** Frame time distribution of a run */
+struct ARCHER_API FArcherFrameTimeSummary
+{
+	int32 NumFrames = 0;
+	float AverageMs = 0.0f;
+	float MedianMs = 0.0f;
+	float Percentile95Ms = 0.0f;
+	float MaxMs = 0.0f;
+};
+
+/** Timing of every frame of a headless run, shared by UArcherBenchmarkSubsystem and UArcherInputReplaySubsystem */
+struct ARCHER_API FArcherFrameTimings
+{
+	TArray<FArcherFrameTiming> Frames;
+
+	FArcherFrameTimings();
+
+	/**
+	 * Drop recorded frames and start timing the next frame from now
+	 * @param ExpectedFrames - frames to reserve memory for, so recording doesn't reallocate mid-run
+	 */
+	void Start(int32 ExpectedFrames = 0);
+
+	/** Record the frame ending now, call once per frame */
+	const FArcherFrameTiming& RecordFrame();
+
+	/** One line per recorded frame: Frame,FrameMs,GameThreadMs */
+	FString ToCsv() const;
+
+	/** Average, median, 95th percentile and worst real frame time */
+	FArcherFrameTimeSummary Summarize() const;
+
+private:
+	double LastFrameTime;
+};
@@ -2,14 +2,29 @@
 
 #include "ArcherGameMode.h"
 #include "ArcherCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "ArcherPlayerController.h"
 
 AArcherGameMode::AArcherGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	// set default pawn class to our Blueprinted character, resolved in InitGame()
+	DefaultPawnClassPath = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter.ThirdPersonCharacter_C")));
+
+	// Times shots to the moment the player clicked and ranks archers by significance against the player's view
+	PlayerControllerClass = AArcherPlayerController::StaticClass();
+}
+
+void AArcherGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	// Only a fallback, blueprinted game modes that pick their own pawn keep it.
+	// Only the pawn itself is loaded here, its weapon content streams in on demand
+	const AGameModeBase* NativeDefaults = AGameModeBase::StaticClass()->GetDefaultObject<AGameModeBase>();
+	if (DefaultPawnClass == NULL || DefaultPawnClass == NativeDefaults->DefaultPawnClass)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		if (UClass* PlayerPawnBPClass = DefaultPawnClassPath.LoadSynchronous())
+		{
+			DefaultPawnClass = PlayerPawnBPClass;
+		}
 	}
+
+	Super::InitGame(MapName, Options, ErrorMessage);
 }
@@ -6,13 +6,22 @@
 #include "GameFramework/GameModeBase.h"
 #include "ArcherGameMode.generated.h"
 
-UCLASS(minimalapi)
+UCLASS(minimalapi, config=Game)
 class AArcherGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AArcherGameMode();
+
+	/**
+	 * Blueprinted character used as DefaultPawnClass when no subclass picked one, loaded when a game starts
+	 * rather than when the module loads
+	 */
+	UPROPERTY(config, EditDefaultsOnly, Category = Classes)
+	TSoftClassPtr<APawn> DefaultPawnClassPath;
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
 };
 
 
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherImpactEventSubsystem.h"
+#include "Archer.h"
+#include "ArcherCharacter.h"
+
+FArcherImpactSummary::FArcherImpactSummary()
+	: NumHits(0)
+	, TotalDamage(0.0f)
+	, Instigator(NULL)
+	, Direction(FVector::ZeroVector)
+	, ImpactPoint(FVector::ZeroVector)
+	, BoneName(NAME_None)
+{
+}
+
+UArcherImpactEventSubsystem::UArcherImpactEventSubsystem()
+{
+	bIsFlushing = false;
+}
+
+void UArcherImpactEventSubsystem::QueueImpact(AArcherCharacter* Victim, AActor* Instigator, float Damage, const FVector& Direction, const FHitResult& Hit)
+{
+	if (Victim == NULL)
+	{
+		return;
+	}
+
+	// Out of room: resolve what is there now rather than lose hits, those victims react twice this frame
+	if (Events.Num() == MaxQueuedImpacts)
+	{
+		if (bIsFlushing)
+		{
+			UE_LOG(LogArcher, Warning, TEXT("Impact queue full while resolving, hit on %s dropped"), *Victim->GetName());
+			return;
+		}
+		Flush();
+	}
+
+	FArcherImpactEvent& Event = Events.AddDefaulted_GetRef();
+	Event.Victim = Victim;
+	Event.VictimId = Victim->GetUniqueID();
+	Event.Instigator = Instigator;
+	Event.Damage = Damage;
+	Event.Direction = Direction.GetSafeNormal();
+	Event.ImpactPoint = Hit.ImpactPoint;
+	Event.BoneName = Hit.BoneName;
+}
+
+void UArcherImpactEventSubsystem::Flush()
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherImpactDispatch);
+
+	const int32 NumEvents = Events.Num();
+	if (NumEvents == 0 || bIsFlushing)
+	{
+		return;
+	}
+	bIsFlushing = true;
+
+	// Group by victim in place, keeping the hits of each victim in the order they happened
+	StableSort(Events.GetData(), NumEvents, [](const FArcherImpactEvent& A, const FArcherImpactEvent& B) { return A.VictimId < B.VictimId; });
+
+	int32 NumVictims = 0;
+	int32 GroupStart = 0;
+	while (GroupStart < NumEvents)
+	{
+		int32 GroupEnd = GroupStart + 1;
+		while (GroupEnd < NumEvents && Events[GroupEnd].VictimId == Events[GroupStart].VictimId)
+		{
+			++GroupEnd;
+		}
+
+		AArcherCharacter* Victim = Events[GroupStart].Victim.Get();
+		if (Victim != NULL && !Victim->IsPendingKill())
+		{
+			FArcherImpactSummary Summary;
+			float HardestHit = -1.0f;
+			for (int32 EventIndex = GroupStart; EventIndex < GroupEnd; ++EventIndex)
+			{
+				const FArcherImpactEvent& Event = Events[EventIndex];
+				++Summary.NumHits;
+				Summary.TotalDamage += Event.Damage;
+				if (Event.Damage > HardestHit)
+				{
+					HardestHit = Event.Damage;
+					Summary.Instigator = Event.Instigator.Get();
+					Summary.Direction = Event.Direction;
+					Summary.ImpactPoint = Event.ImpactPoint;
+					Summary.BoneName = Event.BoneName;
+				}
+			}
+
+			Victim->ApplyImpacts(Summary);
+			++NumVictims;
+		}
+
+		GroupStart = GroupEnd;
+	}
+
+	// Anything queued while resolving stays for the next frame
+	Events.RemoveAt(0, NumEvents, false);
+	bIsFlushing = false;
+
+	INC_DWORD_STAT_BY(STAT_ArcherImpactEvents, NumEvents);
+	INC_DWORD_STAT_BY(STAT_ArcherImpactVictims, NumVictims);
+}
+
+void UArcherImpactEventSubsystem::Tick(float DeltaTime)
+{
+	Flush();
+}
+
+bool UArcherImpactEventSubsystem::IsTickable() const
+{
+	return Events.Num() > 0;
+}
+
+ETickableTickType UArcherImpactEventSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UArcherImpactEventSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UArcherImpactEventSubsystem, STATGROUP_Tickables);
+}
+
+void UArcherImpactEventSubsystem::ResetWorldState()
+{
+	Events.Reset();
+	bIsFlushing = false;
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArcherImpactEventSubsystem.generated.h"
+
+class AArcherCharacter;
+
+/** One arrow hitting an archer, waiting in UArcherImpactEventSubsystem for the end of the frame */
+struct FArcherImpactEvent
+{
+	TWeakObjectPtr<AArcherCharacter> Victim;
+	/** Victim's object index, events are grouped by it */
+	uint32 VictimId;
+	TWeakObjectPtr<AActor> Instigator;
+	float Damage;
+	/** Direction the arrow was flying in */
+	FVector Direction;
+	FVector ImpactPoint;
+	FName BoneName;
+};
+
+/** Everything that hit one archer in a frame, see AArcherCharacter::ApplyImpacts() */
+struct FArcherImpactSummary
+{
+	int32 NumHits;
+	float TotalDamage;
+	/** Instigator, direction and location of the hardest hit */
+	AActor* Instigator;
+	FVector Direction;
+	FVector ImpactPoint;
+	FName BoneName;
+
+	FArcherImpactSummary();
+};
+
+/**
+ * Collects arrow hits on archers during the frame and resolves them together once it is over,
+ * so a volley costs one health update, one reaction and one RPC per victim instead of per arrow.
+ * Events go into a fixed-capacity buffer that never allocates. A full buffer is resolved on the spot.
+ */
+UCLASS()
+class ARCHER_API UArcherImpactEventSubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UArcherImpactEventSubsystem();
+
+	/** Hits a frame can hold before they have to be resolved early */
+	static const int32 MaxQueuedImpacts = 256;
+
+	/**
+	 * Queue hit of an arrow on an archer, call on the authority only
+	 * @param Victim - archer that was hit
+	 * @param Instigator - actor that shot the arrow
+	 * @param Damage - health taken away
+	 * @param Direction - direction the arrow was flying in
+	 * @param Hit - where the arrow hit
+	 */
+	void QueueImpact(AArcherCharacter* Victim, AActor* Instigator, float Damage, const FVector& Direction, const FHitResult& Hit);
+
+	/** Resolve queued hits, every victim is handed all of its hits at once */
+	void Flush();
+
+	/** Returns number of hits waiting to be resolved */
+	int32 GetNumQueuedImpacts() const { return Events.Num(); }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	TArray<FArcherImpactEvent, TFixedAllocator<MaxQueuedImpacts>> Events;
+
+	/** Hits queued by victims reacting to theirs are left for the next Flush() */
+	bool bIsFlushing;
+};
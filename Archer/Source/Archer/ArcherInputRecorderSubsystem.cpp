@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherInputRecorderSubsystem.h"
+#include "Archer.h"
+#include "ArcherCharacter.h"
+#include "ArcherPlayerController.h"
+#include "Components/InputComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerInput.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+
+bool UArcherInputRecorderSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	FString Name;
+	return FParse::Value(FCommandLine::Get(), TEXT("ArcherRecord="), Name);
+}
+
+void UArcherInputRecorderSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FString Name;
+	FParse::Value(FCommandLine::Get(), TEXT("ArcherRecord="), Name);
+	Filename = GetRecordingFilename(Name);
+	StartTime = INDEX_NONE;
+
+	UE_LOG(LogArcher, Display, TEXT("Recording archer input to %s"), *Filename);
+}
+
+void UArcherInputRecorderSubsystem::Deinitialize()
+{
+	SaveRecording();
+
+	Super::Deinitialize();
+}
+
+FString UArcherInputRecorderSubsystem::GetRecordingFilename(const FString& Name)
+{
+	return FPaths::IsRelative(Name) ? FPaths::ProjectSavedDir() / TEXT("InputRecordings") / Name : Name;
+}
+
+void UArcherInputRecorderSubsystem::Tick(float DeltaTime)
+{
+	UWorld* const World = GetWorld();
+	APlayerController* PlayerController = World != NULL ? World->GetFirstPlayerController() : NULL;
+	AArcherCharacter* Archer = PlayerController != NULL ? Cast<AArcherCharacter>(PlayerController->GetPawn()) : NULL;
+	if (Archer == NULL || Archer->InputComponent == NULL || PlayerController->PlayerInput == NULL)
+	{
+		return;
+	}
+
+	if (StartTime == INDEX_NONE)
+	{
+		StartTime = World->GetTimeSeconds();
+	}
+
+	// Ticks after the world, so this is the input the archer got this frame
+	FArcherInputFrame Frame;
+	Frame.Time = World->GetTimeSeconds() - StartTime;
+	Frame.SetMoveInput(Archer->InputComponent->GetAxisValue(TEXT("MoveForward")), Archer->InputComponent->GetAxisValue(TEXT("MoveRight")));
+	Frame.SetControlRotation(PlayerController->GetControlRotation());
+
+	for (int32 Index = 0; Index < int32(EArcherInputAction::Num); ++Index)
+	{
+		const EArcherInputAction Action = EArcherInputAction(Index);
+		const FName ActionName = FArcherInputRecording::GetActionName(Action);
+		if (WasActionKeyJust(PlayerController, ActionName, true))
+		{
+			Frame.SetPressed(Action);
+		}
+		if (WasActionKeyJust(PlayerController, ActionName, false))
+		{
+			Frame.SetReleased(Action);
+		}
+	}
+
+	// Timed shots replay with the rotation and flight time they were released with, not the frame's
+	float ShotAlpha;
+	float ShotTimeAhead;
+	const AArcherPlayerController* ArcherController = Cast<AArcherPlayerController>(PlayerController);
+	if (Frame.WasPressed(EArcherInputAction::Shoot) && ArcherController != NULL && ArcherController->GetReleasedShotTiming(ShotAlpha, ShotTimeAhead))
+	{
+		Frame.SetShotTiming(ShotAlpha, ShotTimeAhead);
+	}
+
+	Recording.AddFrame(Frame);
+}
+
+bool UArcherInputRecorderSubsystem::IsTickable() const
+{
+	return !Filename.IsEmpty();
+}
+
+ETickableTickType UArcherInputRecorderSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UArcherInputRecorderSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UArcherInputRecorderSubsystem, STATGROUP_Tickables);
+}
+
+void UArcherInputRecorderSubsystem::ResetWorldState()
+{
+	// One recording per run, a map change ends it
+	SaveRecording();
+}
+
+bool UArcherInputRecorderSubsystem::WasActionKeyJust(const APlayerController* PlayerController, FName ActionName, bool bPressed)
+{
+	for (const FInputActionKeyMapping& Mapping : PlayerController->PlayerInput->GetKeysForAction(ActionName))
+	{
+		if (bPressed ? PlayerController->WasInputKeyJustPressed(Mapping.Key) : PlayerController->WasInputKeyJustReleased(Mapping.Key))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UArcherInputRecorderSubsystem::SaveRecording()
+{
+	if (Filename.IsEmpty() || Recording.Frames.Num() == 0)
+	{
+		return;
+	}
+
+	if (Recording.SaveToFile(Filename))
+	{
+		UE_LOG(LogArcher, Display, TEXT("Archer input recording written to %s, %d frames over %.1f s"), *Filename, Recording.Frames.Num(), Recording.GetDuration());
+	}
+	else
+	{
+		UE_LOG(LogArcher, Error, TEXT("Can't write archer input recording %s"), *Filename);
+	}
+
+	// Nothing more is recorded after the first world
+	Filename.Empty();
+}
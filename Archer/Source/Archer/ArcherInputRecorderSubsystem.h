@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArcherInputRecording.h"
+#include "ArcherInputRecorderSubsystem.generated.h"
+
+class APlayerController;
+
+/**
+ * Records what the local player does with their archer. Enabled with -ArcherRecord on the command line, e.g.
+ *   UE4Editor Archer.uproject /Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap -game -ArcherRecord=Skirmish.arcinput
+ * Every frame samples the bound axes, the action bindings pressed and released and the control rotation,
+ * and writes them to the file when the world goes away. Relative paths are put in Saved/InputRecordings.
+ * Play the file back with UArcherInputReplaySubsystem.
+ */
+UCLASS()
+class ARCHER_API UArcherInputRecorderSubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Resolve recording name given on the command line to a file name */
+	static FString GetRecordingFilename(const FString& Name);
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	/** Any key mapped to the action had the event this frame */
+	static bool WasActionKeyJust(const APlayerController* PlayerController, FName ActionName, bool bPressed);
+
+	void SaveRecording();
+
+	FString Filename;
+	FArcherInputRecording Recording;
+
+	/** World time of the first recorded frame, INDEX_NONE until the player has an archer */
+	float StartTime;
+};
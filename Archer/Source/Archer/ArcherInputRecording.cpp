@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherInputRecording.h"
+#include "Archer.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace ArcherInputRecording
+{
+	/** 'ARIR', first bytes of every recording file */
+	static const uint32 Magic = 0x52495241;
+
+	/** Bump when the frame layout changes, old recordings are refused instead of replayed wrong */
+	static const uint32 Version = 2;
+
+	/** Shot time ahead steps per second */
+	static const float ShotTimeAheadScale = 10000.0f;
+}
+
+FArcherInputFrame::FArcherInputFrame()
+	: Time(0.0f)
+	, MoveForward(0)
+	, MoveRight(0)
+	, PressedActions(0)
+	, ReleasedActions(0)
+	, ControlYaw(0)
+	, ControlPitch(0)
+	, bIsShotTimed(false)
+	, ShotAlpha(0)
+	, ShotTimeAhead(0)
+{
+}
+
+void FArcherInputFrame::SetMoveInput(float Forward, float Right)
+{
+	MoveForward = int8(FMath::RoundToInt(FMath::Clamp(Forward, -1.0f, 1.0f) * MAX_int8));
+	MoveRight = int8(FMath::RoundToInt(FMath::Clamp(Right, -1.0f, 1.0f) * MAX_int8));
+}
+
+float FArcherInputFrame::GetMoveForward() const
+{
+	return float(MoveForward) / MAX_int8;
+}
+
+float FArcherInputFrame::GetMoveRight() const
+{
+	return float(MoveRight) / MAX_int8;
+}
+
+void FArcherInputFrame::SetControlRotation(const FRotator& Rotation)
+{
+	ControlYaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+	ControlPitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+}
+
+FRotator FArcherInputFrame::GetControlRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(ControlPitch), FRotator::DecompressAxisFromShort(ControlYaw), 0.0f);
+}
+
+void FArcherInputFrame::SetShotTiming(float Alpha, float TimeAhead)
+{
+	bIsShotTimed = true;
+	ShotAlpha = uint8(FMath::RoundToInt(FMath::Clamp(Alpha, 0.0f, 1.0f) * MAX_uint8));
+	ShotTimeAhead = uint16(FMath::Clamp(FMath::RoundToInt(TimeAhead * ArcherInputRecording::ShotTimeAheadScale), 0, int32(MAX_uint16)));
+}
+
+float FArcherInputFrame::GetShotAlpha() const
+{
+	return float(ShotAlpha) / MAX_uint8;
+}
+
+float FArcherInputFrame::GetShotTimeAhead() const
+{
+	return float(ShotTimeAhead) / ArcherInputRecording::ShotTimeAheadScale;
+}
+
+bool FArcherInputFrame::HasSameStateAs(const FArcherInputFrame& Other) const
+{
+	return PressedActions == 0 && ReleasedActions == 0
+		&& MoveForward == Other.MoveForward && MoveRight == Other.MoveRight
+		&& ControlYaw == Other.ControlYaw && ControlPitch == Other.ControlPitch;
+}
+
+FArchive& operator<<(FArchive& Ar, FArcherInputFrame& Frame)
+{
+	Ar << Frame.Time;
+	Ar << Frame.MoveForward;
+	Ar << Frame.MoveRight;
+	Ar << Frame.PressedActions;
+	Ar << Frame.ReleasedActions;
+	Ar << Frame.ControlYaw;
+	Ar << Frame.ControlPitch;
+
+	if (Frame.WasPressed(EArcherInputAction::Shoot))
+	{
+		uint8 bIsShotTimed = Frame.bIsShotTimed;
+		Ar << bIsShotTimed;
+		Frame.bIsShotTimed = bIsShotTimed != 0;
+		if (Frame.bIsShotTimed)
+		{
+			Ar << Frame.ShotAlpha;
+			Ar << Frame.ShotTimeAhead;
+		}
+	}
+	return Ar;
+}
+
+FName FArcherInputRecording::GetActionName(EArcherInputAction Action)
+{
+	static const FName ActionNames[] = { TEXT("Jump"), TEXT("Sprint"), TEXT("Aim"), TEXT("Shoot"), TEXT("WalkMode"), TEXT("EquipWeapon") };
+	static_assert(ARRAY_COUNT(ActionNames) == int32(EArcherInputAction::Num), "Every archer input action needs a name");
+
+	return ActionNames[int32(Action)];
+}
+
+void FArcherInputRecording::AddFrame(const FArcherInputFrame& Frame)
+{
+	if (Frames.Num() > 0 && Frame.HasSameStateAs(Frames.Last()))
+	{
+		return;
+	}
+	Frames.Add(Frame);
+}
+
+float FArcherInputRecording::GetDuration() const
+{
+	return Frames.Num() > 0 ? Frames.Last().Time : 0.0f;
+}
+
+bool FArcherInputRecording::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	Writer << const_cast<FArcherInputRecording&>(*this);
+
+	return FFileHelper::SaveArrayToFile(Data, *Filename);
+}
+
+bool FArcherInputRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Filename))
+	{
+		UE_LOG(LogArcher, Warning, TEXT("Can't read archer input recording %s"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+	Reader << *this;
+	if (Reader.IsError())
+	{
+		UE_LOG(LogArcher, Warning, TEXT("%s is not an archer input recording of version %u"), *Filename, ArcherInputRecording::Version);
+		Frames.Reset();
+		return false;
+	}
+	return true;
+}
+
+FArchive& operator<<(FArchive& Ar, FArcherInputRecording& Recording)
+{
+	uint32 Magic = ArcherInputRecording::Magic;
+	uint32 Version = ArcherInputRecording::Version;
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != ArcherInputRecording::Magic || Version != ArcherInputRecording::Version)
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Recording.Frames;
+	return Ar;
+}
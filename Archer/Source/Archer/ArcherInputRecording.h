@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Archer input actions, in the order they are stored in FArcherInputFrame action masks */
+enum class EArcherInputAction : uint8
+{
+	Jump,
+	Sprint,
+	Aim,
+	Shoot,
+	WalkMode,
+	EquipWeapon,
+	Num
+};
+
+/**
+ * State of archer input at one point of a recording. Axes and control rotation are held until the next frame,
+ * actions are edges that happened since the previous frame. Quantized to keep recordings small.
+ */
+struct ARCHER_API FArcherInputFrame
+{
+	/** Seconds since the recording started */
+	float Time;
+
+	int8 MoveForward;
+	int8 MoveRight;
+
+	/** Actions pressed and released since the previous frame, bit per EArcherInputAction */
+	uint8 PressedActions;
+	uint8 ReleasedActions;
+
+	FArcherInputFrame();
+
+	void SetMoveInput(float Forward, float Right);
+	float GetMoveForward() const;
+	float GetMoveRight() const;
+
+	void SetControlRotation(const FRotator& Rotation);
+	FRotator GetControlRotation() const;
+
+	FORCEINLINE void SetPressed(EArcherInputAction Action) { PressedActions |= 1 << uint8(Action); }
+	FORCEINLINE void SetReleased(EArcherInputAction Action) { ReleasedActions |= 1 << uint8(Action); }
+	FORCEINLINE bool WasPressed(EArcherInputAction Action) const { return (PressedActions & (1 << uint8(Action))) != 0; }
+	FORCEINLINE bool WasReleased(EArcherInputAction Action) const { return (ReleasedActions & (1 << uint8(Action))) != 0; }
+
+	/**
+	 * Shoot press timed by AArcherPlayerController::DeferShot(), replayed with AArcherCharacter::ReleaseArrow()
+	 * @param Alpha - where the release was between the previous frame's control rotation and this one's
+	 * @param TimeAhead - seconds the arrow had been flying when it was released
+	 */
+	void SetShotTiming(float Alpha, float TimeAhead);
+	FORCEINLINE bool IsShotTimed() const { return bIsShotTimed; }
+	float GetShotAlpha() const;
+	float GetShotTimeAhead() const;
+
+	/** Returns true if replaying this frame after Other does the same as replaying Other alone */
+	bool HasSameStateAs(const FArcherInputFrame& Other) const;
+
+	friend FArchive& operator<<(FArchive& Ar, FArcherInputFrame& Frame);
+
+private:
+	uint16 ControlYaw;
+	uint16 ControlPitch;
+
+	/** Only stored with a Shoot press */
+	bool bIsShotTimed;
+	uint8 ShotAlpha;
+	/** Tenths of a millisecond */
+	uint16 ShotTimeAhead;
+};
+
+/** Archer input captured from one player, see UArcherInputRecorderSubsystem and UArcherInputReplaySubsystem */
+struct ARCHER_API FArcherInputRecording
+{
+	/** Frames in time order, frames that change nothing are left out */
+	TArray<FArcherInputFrame> Frames;
+
+	/** Input action name of the binding in AArcherCharacter::SetupPlayerInputComponent() */
+	static FName GetActionName(EArcherInputAction Action);
+
+	/** Append Frame unless it repeats the last one */
+	void AddFrame(const FArcherInputFrame& Frame);
+
+	float GetDuration() const;
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+
+	friend FArchive& operator<<(FArchive& Ar, FArcherInputRecording& Recording);
+};
@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherInputReplaySubsystem.h"
+#include "Archer.h"
+#include "ArcherCharacter.h"
+#include "ArcherInputRecorderSubsystem.h"
+#include "AIController.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace ArcherInputReplay
+{
+	/** Distance between archers spawned on the grid */
+	static const float ArcherSpacing = 400.0f;
+
+	/** Keep running this long after the last recorded input so arrows in flight are part of the profile */
+	static const float SettleSeconds = 2.0f;
+}
+
+bool UArcherInputReplaySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	FString Names;
+	return FParse::Value(FCommandLine::Get(), TEXT("ArcherReplay="), Names);
+}
+
+void UArcherInputReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	FString Names;
+	FParse::Value(CommandLine, TEXT("ArcherReplay="), Names);
+	TArray<FString> NameList;
+	Names.ParseIntoArray(NameList, TEXT(","), true);
+
+	ReplayDuration = 0.0f;
+	for (const FString& Name : NameList)
+	{
+		FArcherInputRecording Recording;
+		if (Recording.LoadFromFile(UArcherInputRecorderSubsystem::GetRecordingFilename(Name)) && Recording.Frames.Num() > 0)
+		{
+			ReplayDuration = FMath::Max(ReplayDuration, Recording.GetDuration());
+			Recordings.Add(MoveTemp(Recording));
+		}
+	}
+
+	NumArchers = Recordings.Num();
+	FParse::Value(CommandLine, TEXT("ArcherReplayCount="), NumArchers);
+	NumArchers = FMath::Max(NumArchers, 1);
+
+	float FramesPerSecond = 60.0f;
+	FParse::Value(CommandLine, TEXT("ArcherReplayFPS="), FramesPerSecond);
+
+	ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmark/ArcherReplay.csv");
+	FParse::Value(CommandLine, TEXT("ArcherReplayReport="), ReportPath);
+
+	bIsReplaying = false;
+	ReplayTime = 0.0f;
+
+	if (Recordings.Num() == 0)
+	{
+		UE_LOG(LogArcher, Error, TEXT("No archer input recording could be loaded from '%s', nothing to replay"), *Names);
+		return;
+	}
+
+	// Same simulation steps on every run no matter how long a frame takes
+	FApp::SetBenchmarking(true);
+	FApp::SetFixedDeltaTime(1.0 / FMath::Max(FramesPerSecond, 1.0f));
+
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UArcherInputReplaySubsystem::OnPostLoadMap);
+
+	UE_LOG(LogArcher, Display, TEXT("Archer input replay enabled, %d recordings on %d archers at %g fps"), Recordings.Num(), NumArchers, FramesPerSecond);
+}
+
+void UArcherInputReplaySubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+	Super::Deinitialize();
+}
+
+void UArcherInputReplaySubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	if (bIsReplaying || LoadedWorld == NULL || LoadedWorld != GetWorld())
+	{
+		return;
+	}
+
+	SpawnArchers();
+
+	bIsReplaying = true;
+	ReplayTime = 0.0f;
+	FrameTimings.Start(FMath::CeilToInt((ReplayDuration + ArcherInputReplay::SettleSeconds) / FApp::GetFixedDeltaTime()) + 1);
+}
+
+void UArcherInputReplaySubsystem::Tick(float DeltaTime)
+{
+	FrameTimings.RecordFrame();
+
+	ReplayTime += DeltaTime;
+
+	for (FReplayedArcher& Replayed : ReplayedArchers)
+	{
+		AArcherCharacter* Archer = Replayed.Archer.Get();
+		const TArray<FArcherInputFrame>& Frames = Recordings[Replayed.RecordingIndex].Frames;
+		if (Archer == NULL || (Replayed.NextFrame == 0 && Frames[0].Time > ReplayTime))
+		{
+			continue;
+		}
+
+		// Latest axes and rotation, plus every action edge of the frames passed since last tick
+		FArcherInputFrame Input = Frames[FMath::Max(Replayed.NextFrame - 1, 0)];
+		Input.PressedActions = 0;
+		Input.ReleasedActions = 0;
+		const FArcherInputFrame* ShotFrame = NULL;
+		while (Replayed.NextFrame < Frames.Num() && Frames[Replayed.NextFrame].Time <= ReplayTime)
+		{
+			const FArcherInputFrame& Frame = Frames[Replayed.NextFrame++];
+			const uint8 PressedActions = Input.PressedActions | Frame.PressedActions;
+			const uint8 ReleasedActions = Input.ReleasedActions | Frame.ReleasedActions;
+			Input = Frame;
+			Input.PressedActions = PressedActions;
+			Input.ReleasedActions = ReleasedActions;
+			if (Frame.WasPressed(EArcherInputAction::Shoot))
+			{
+				ShotFrame = &Frame;
+			}
+		}
+
+		// Shot keeps its timing when later frames are folded into the same tick
+		if (ShotFrame != NULL && ShotFrame->IsShotTimed())
+		{
+			Input.SetShotTiming(ShotFrame->GetShotAlpha(), ShotFrame->GetShotTimeAhead());
+		}
+
+		Archer->ApplyInputFrame(Input);
+	}
+
+	if (ReplayTime >= ReplayDuration + ArcherInputReplay::SettleSeconds)
+	{
+		FinishReplay();
+	}
+}
+
+bool UArcherInputReplaySubsystem::IsTickable() const
+{
+	return bIsReplaying;
+}
+
+ETickableTickType UArcherInputReplaySubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UArcherInputReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UArcherInputReplaySubsystem, STATGROUP_Tickables);
+}
+
+void UArcherInputReplaySubsystem::ResetWorldState()
+{
+	ReplayedArchers.Reset();
+
+	if (bIsReplaying)
+	{
+		UE_LOG(LogArcher, Warning, TEXT("Archer input replay world was torn down before the recordings ended"));
+		FinishReplay();
+	}
+}
+
+void UArcherInputReplaySubsystem::SpawnArchers()
+{
+	UWorld* const World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* PawnClass = GameMode != NULL ? GameMode->DefaultPawnClass.Get() : nullptr;
+	if (PawnClass == NULL || !PawnClass->IsChildOf(AArcherCharacter::StaticClass()))
+	{
+		PawnClass = AArcherCharacter::StaticClass();
+	}
+
+	// Recordings steer with absolute control rotation, so all archers start facing the same way
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(float(NumArchers)));
+	const FVector Origin = FVector(0.0f, 0.0f, 200.0f);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	for (int32 Index = 0; Index < NumArchers; ++Index)
+	{
+		const FVector Location = Origin + FVector((Index / GridSize) * ArcherInputReplay::ArcherSpacing, (Index % GridSize) * ArcherInputReplay::ArcherSpacing, 0.0f);
+		AArcherCharacter* Archer = World->SpawnActor<AArcherCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Archer == NULL)
+		{
+			continue;
+		}
+
+		// Movement input and shots need a local controller, one that leaves control rotation to the recording
+		Archer->SpawnDefaultController();
+		if (AAIController* AIController = Cast<AAIController>(Archer->GetController()))
+		{
+			AIController->bSetControlRotationFromPawnOrientation = false;
+		}
+		Archer->PreloadWeaponContent();
+
+		FReplayedArcher Replayed;
+		Replayed.Archer = Archer;
+		Replayed.RecordingIndex = Index % Recordings.Num();
+		Replayed.NextFrame = 0;
+		ReplayedArchers.Add(Replayed);
+	}
+}
+
+void UArcherInputReplaySubsystem::DestroyArchers()
+{
+	for (const FReplayedArcher& Replayed : ReplayedArchers)
+	{
+		if (Replayed.Archer.IsValid())
+		{
+			if (AController* Controller = Replayed.Archer->GetController())
+			{
+				Controller->Destroy();
+			}
+			Replayed.Archer->Destroy();
+		}
+	}
+	ReplayedArchers.Reset();
+}
+
+void UArcherInputReplaySubsystem::FinishReplay()
+{
+	bIsReplaying = false;
+	DestroyArchers();
+
+	// First frame includes the map load, it is not part of the replay
+	if (FrameTimings.Frames.Num() > 0)
+	{
+		FrameTimings.Frames.RemoveAt(0);
+	}
+	FFileHelper::SaveStringToFile(FrameTimings.ToCsv(), *ReportPath);
+
+	const FArcherFrameTimeSummary Summary = FrameTimings.Summarize();
+	if (Summary.NumFrames > 0)
+	{
+		UE_LOG(LogArcher, Display, TEXT("Archer input replay: %d frames, frame time avg %.3f ms, median %.3f ms, 95th %.3f ms, max %.3f ms. Written to %s"),
+			Summary.NumFrames, Summary.AverageMs, Summary.MedianMs, Summary.Percentile95Ms, Summary.MaxMs, *ReportPath);
+	}
+
+	FPlatformMisc::RequestExitWithStatus(false, 0);
+}
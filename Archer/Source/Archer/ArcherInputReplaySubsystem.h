@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArcherInputRecording.h"
+#include "ArcherFrameTiming.h"
+#include "ArcherInputReplaySubsystem.generated.h"
+
+class AArcherCharacter;
+
+/**
+ * Headless playback of archer input recordings for frame time regression runs. Enabled with -ArcherReplay, e.g.
+ *   UE4Editor Archer.uproject /Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap -game -nullrhi -unattended
+ *     -ArcherReplay=Skirmish.arcinput,Sniping.arcinput -ArcherReplayCount=32 -ArcherReplayFPS=60 -ArcherReplayReport=Saved/Benchmark/ArcherReplay.csv
+ * Spawns ArcherReplayCount archers (one per recording by default) and drives them with the recordings in turn.
+ * The engine runs at a fixed timestep of 1/ArcherReplayFPS as fast as it can, so every build replays the same
+ * gameplay frame by frame. Real time of every frame is written as CSV, the process exits once all recordings ended.
+ */
+UCLASS()
+class ARCHER_API UArcherInputReplaySubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	struct FReplayedArcher
+	{
+		TWeakObjectPtr<AArcherCharacter> Archer;
+		int32 RecordingIndex;
+		/** Next frame of the recording to apply */
+		int32 NextFrame;
+	};
+
+	void OnPostLoadMap(UWorld* LoadedWorld);
+
+	void SpawnArchers();
+	void DestroyArchers();
+
+	void FinishReplay();
+
+	TArray<FArcherInputRecording> Recordings;
+	TArray<FReplayedArcher> ReplayedArchers;
+	FArcherFrameTimings FrameTimings;
+
+	int32 NumArchers;
+	FString ReportPath;
+
+	bool bIsReplaying;
+	float ReplayTime;
+	float ReplayDuration;
+
+	FDelegateHandle PostLoadMapHandle;
+};
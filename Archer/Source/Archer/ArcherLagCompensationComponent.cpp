@@ -0,0 +1,314 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherLagCompensationComponent.h"
+#include "Archer.h"
+#include "ArcherCharacter.h"
+#include "ArcherSpatialIndexSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/EngineTypes.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+
+namespace ArcherLagCompensation
+{
+	/** Fraction of Delta at which a point moving from Start enters the sphere, 0 when it starts inside */
+	bool SweepSphere(const FVector& Start, const FVector& Delta, const FVector& Center, float Radius, float& OutTime)
+	{
+		const FVector Offset = Start - Center;
+		const float C = Offset.SizeSquared() - FMath::Square(Radius);
+		if (C <= 0.0f)
+		{
+			OutTime = 0.0f;
+			return true;
+		}
+
+		const float A = Delta.SizeSquared();
+		const float B = 2.0f * (Delta | Offset);
+		const float Discriminant = B * B - 4.0f * A * C;
+		if (A <= SMALL_NUMBER || Discriminant < 0.0f)
+		{
+			return false;
+		}
+
+		OutTime = (-B - FMath::Sqrt(Discriminant)) / (2.0f * A);
+		return OutTime >= 0.0f && OutTime <= 1.0f;
+	}
+
+	/** Same for an upright capsule, HalfAxis is half the length of the segment between its end sphere centers */
+	bool SweepCapsule(const FVector& Start, const FVector& Delta, const FVector& Center, float HalfAxis, float Radius, float& OutTime)
+	{
+		const FVector Offset = Start - Center;
+		const float C = Offset.SizeSquared2D() - FMath::Square(Radius);
+		if (C <= 0.0f && FMath::Abs(Offset.Z) <= HalfAxis)
+		{
+			OutTime = 0.0f;
+			return true;
+		}
+
+		bool bHit = false;
+		OutTime = MAX_flt;
+
+		// Side of the cylinder, only where it is between the end spheres
+		const float A = Delta.SizeSquared2D();
+		const float B = 2.0f * (Delta.X * Offset.X + Delta.Y * Offset.Y);
+		const float Discriminant = B * B - 4.0f * A * C;
+		if (A > SMALL_NUMBER && Discriminant >= 0.0f)
+		{
+			const float SideTime = (-B - FMath::Sqrt(Discriminant)) / (2.0f * A);
+			if (SideTime >= 0.0f && SideTime <= 1.0f && FMath::Abs(Offset.Z + Delta.Z * SideTime) <= HalfAxis)
+			{
+				OutTime = SideTime;
+				bHit = true;
+			}
+		}
+
+		const FVector AxisOffset(0.0f, 0.0f, HalfAxis);
+		float CapTime;
+		if (SweepSphere(Start, Delta, Center - AxisOffset, Radius, CapTime) && CapTime < OutTime)
+		{
+			OutTime = CapTime;
+			bHit = true;
+		}
+		if (SweepSphere(Start, Delta, Center + AxisOffset, Radius, CapTime) && CapTime < OutTime)
+		{
+			OutTime = CapTime;
+			bHit = true;
+		}
+		return bHit;
+	}
+}
+
+UArcherLagCompensationComponent::UArcherLagCompensationComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	// Record where the archer ended up this frame
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+
+	HistoryDuration = 0.5f;
+	RecordRate = 30.0f;
+	HitTolerance = 10.0f;
+	RewindResolution = 0.005f;
+
+	Hitboxes.Add(FArcherHitbox(TEXT("head"), 15.0f));
+	Hitboxes.Add(FArcherHitbox(TEXT("spine_03"), 20.0f));
+	Hitboxes.Add(FArcherHitbox(TEXT("pelvis"), 20.0f));
+
+	MaxFrames = 0;
+	NumFrames = 0;
+	Head = 0;
+	CapsuleRadius = 0.0f;
+	CapsuleHalfHeight = 0.0f;
+	bIsRewoundFrameValid = false;
+}
+
+void UArcherLagCompensationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Only a server validates hits of other players
+	const ENetMode NetMode = GetNetMode();
+	if (NetMode != NM_DedicatedServer && NetMode != NM_ListenServer)
+	{
+		return;
+	}
+
+	const ACharacter* Character = CastChecked<ACharacter>(GetOwner());
+	const USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+	BoneIndices.Reset();
+	BoneRadii.Reset();
+	BoneNames.Reset();
+	for (const FArcherHitbox& Hitbox : Hitboxes)
+	{
+		const int32 BoneIndex = Mesh->GetBoneIndex(Hitbox.BoneName);
+		if (BoneIndex == INDEX_NONE)
+		{
+			UE_LOG(LogArcher, Warning, TEXT("%s: no bone %s for lag compensation hitbox"), *GetNameSafe(GetOwner()), *Hitbox.BoneName.ToString());
+			continue;
+		}
+		BoneIndices.Add(BoneIndex);
+		BoneRadii.Add(Hitbox.Radius);
+		BoneNames.Add(Hitbox.BoneName);
+	}
+
+	// Everything is allocated here, recording and rewinding only write into these
+	MaxFrames = FMath::Max(FMath::CeilToInt(HistoryDuration * RecordRate) + 1, 2);
+	NumFrames = 0;
+	Head = 0;
+	FrameTimes.SetNumZeroed(MaxFrames);
+	CapsuleLocations.SetNumZeroed(MaxFrames);
+	BoneLocations.SetNumZeroed(MaxFrames * BoneIndices.Num());
+	RewoundFrame.Step = 0;
+	RewoundFrame.BoneLocations.SetNumZeroed(BoneIndices.Num());
+
+	CapsuleRadius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	CapsuleHalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	SetComponentTickInterval(1.0f / RecordRate);
+	SetComponentTickEnabled(true);
+	RecordFrame();
+}
+
+void UArcherLagCompensationComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	RecordFrame();
+}
+
+void UArcherLagCompensationComponent::RecordFrame()
+{
+	const ACharacter* Character = CastChecked<ACharacter>(GetOwner());
+	const USkeletalMeshComponent* Mesh = Character->GetMesh();
+	const int32 NumBones = BoneIndices.Num();
+
+	FrameTimes[Head] = GetWorld()->GetTimeSeconds();
+	CapsuleLocations[Head] = Character->GetActorLocation();
+	for (int32 BoneSlot = 0; BoneSlot < NumBones; ++BoneSlot)
+	{
+		BoneLocations[Head * NumBones + BoneSlot] = Mesh->GetBoneTransform(BoneIndices[BoneSlot]).GetLocation();
+	}
+
+	Head = (Head + 1) % MaxFrames;
+	NumFrames = FMath::Min(NumFrames + 1, MaxFrames);
+	bIsRewoundFrameValid = false;
+}
+
+float UArcherLagCompensationComponent::GetRecordedDuration() const
+{
+	return NumFrames > 1 ? FrameTimes[GetSlot(0)] - FrameTimes[GetSlot(NumFrames - 1)] : 0.0f;
+}
+
+const UArcherLagCompensationComponent::FRewoundFrame& UArcherLagCompensationComponent::Rewind(float Time) const
+{
+	// Keyed on the step rather than the exact time, shots of one frame differ by a little latency each
+	const double Resolution = FMath::Max(RewindResolution, KINDA_SMALL_NUMBER);
+	const int64 Step = int64(FMath::RoundToDouble(Time / Resolution));
+	if (bIsRewoundFrameValid && RewoundFrame.Step == Step)
+	{
+		return RewoundFrame;
+	}
+	Time = float(Step * Resolution);
+
+	// Binary search by age for the newest frame not after Time, frames get older as age grows
+	int32 Low = 0;
+	int32 High = NumFrames - 1;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (FrameTimes[GetSlot(Mid)] <= Time)
+		{
+			High = Mid;
+		}
+		else
+		{
+			Low = Mid + 1;
+		}
+	}
+
+	const int32 OlderSlot = GetSlot(Low);
+	const int32 NewerSlot = GetSlot(FMath::Max(Low - 1, 0));
+	const float FrameSpan = FrameTimes[NewerSlot] - FrameTimes[OlderSlot];
+	// Before the oldest frame or after the newest one clamps to it
+	const float Alpha = FrameSpan > 0.0f ? FMath::Clamp((Time - FrameTimes[OlderSlot]) / FrameSpan, 0.0f, 1.0f) : 0.0f;
+
+	const int32 NumBones = BoneIndices.Num();
+	RewoundFrame.Step = Step;
+	RewoundFrame.CapsuleLocation = FMath::Lerp(CapsuleLocations[OlderSlot], CapsuleLocations[NewerSlot], Alpha);
+	for (int32 BoneSlot = 0; BoneSlot < NumBones; ++BoneSlot)
+	{
+		RewoundFrame.BoneLocations[BoneSlot] = FMath::Lerp(BoneLocations[OlderSlot * NumBones + BoneSlot], BoneLocations[NewerSlot * NumBones + BoneSlot], Alpha);
+	}
+	bIsRewoundFrameValid = true;
+
+	return RewoundFrame;
+}
+
+bool UArcherLagCompensationComponent::ValidateHit(float Time, const FVector& Start, const FVector& End, float Radius, FHitResult& OutHit) const
+{
+	// Nothing recorded, e.g. not a server, nothing to sweep against
+	if (NumFrames == 0)
+	{
+		return false;
+	}
+
+	const FRewoundFrame& Frame = Rewind(Time);
+	const FVector Delta = End - Start;
+	const float Inflation = Radius + HitTolerance;
+
+	float BestTime = MAX_flt;
+	FVector BestCenter = FVector::ZeroVector;
+	FName BestBoneName = NAME_None;
+
+	// Capsule is upright, its end spheres and the cylinder between them
+	const float HalfAxis = CapsuleHalfHeight - CapsuleRadius;
+	const float CapsuleSweepRadius = CapsuleRadius + Inflation;
+	float EntryTime;
+	if (ArcherLagCompensation::SweepCapsule(Start, Delta, Frame.CapsuleLocation, HalfAxis, CapsuleSweepRadius, EntryTime) && EntryTime < BestTime)
+	{
+		BestTime = EntryTime;
+		const FVector EntryLocation = Start + Delta * EntryTime;
+		BestCenter = Frame.CapsuleLocation + FVector(0.0f, 0.0f, FMath::Clamp(EntryLocation.Z - Frame.CapsuleLocation.Z, -HalfAxis, HalfAxis));
+	}
+
+	for (int32 BoneSlot = 0; BoneSlot < Frame.BoneLocations.Num(); ++BoneSlot)
+	{
+		if (ArcherLagCompensation::SweepSphere(Start, Delta, Frame.BoneLocations[BoneSlot], BoneRadii[BoneSlot] + Inflation, EntryTime) && EntryTime <= BestTime)
+		{
+			BestTime = EntryTime;
+			BestCenter = Frame.BoneLocations[BoneSlot];
+			BestBoneName = BoneNames[BoneSlot];
+		}
+	}
+
+	if (BestTime == MAX_flt)
+	{
+		return false;
+	}
+
+	const FVector EntryLocation = Start + Delta * BestTime;
+	const FVector Normal = (EntryLocation - BestCenter).GetSafeNormal();
+	OutHit.bBlockingHit = true;
+	OutHit.bStartPenetrating = BestTime == 0.0f;
+	OutHit.Time = BestTime;
+	OutHit.TraceStart = Start;
+	OutHit.TraceEnd = End;
+	OutHit.Location = EntryLocation;
+	OutHit.ImpactPoint = EntryLocation - Normal * Radius;
+	OutHit.Normal = Normal;
+	OutHit.ImpactNormal = Normal;
+	OutHit.BoneName = BestBoneName;
+	return true;
+}
+
+bool UArcherLagCompensationComponent::SweepRewoundArchers(const UObject* WorldContextObject, float Time, const FVector& Start, const FVector& End, float Radius, float QueryRadius, const AActor* IgnoredActor, FHitResult& OutHit)
+{
+	const UArcherSpatialIndexSubsystem* SpatialIndex = UArcherWorldSubsystem::Get<UArcherSpatialIndexSubsystem>(WorldContextObject);
+	if (SpatialIndex == NULL || Start.Equals(End))
+	{
+		return false;
+	}
+
+	TArray<AArcherCharacter*> Archers;
+	SpatialIndex->QuerySegment(Start, End, QueryRadius, IgnoredActor, Archers);
+
+	bool bHit = false;
+	for (AArcherCharacter* Archer : Archers)
+	{
+		FHitResult Hit;
+		if (!Archer->IsAlive() || !Archer->GetLagCompensation()->ValidateHit(Time, Start, End, Radius, Hit) || (bHit && Hit.Time >= OutHit.Time))
+		{
+			continue;
+		}
+
+		// Bone hitboxes belong to the mesh, the rest to the capsule
+		Hit.Actor = Archer;
+		Hit.Component = Hit.BoneName != NAME_None ? static_cast<UPrimitiveComponent*>(Archer->GetMesh()) : static_cast<UPrimitiveComponent*>(Archer->GetCapsuleComponent());
+		OutHit = Hit;
+		bHit = true;
+	}
+	return bHit;
+}
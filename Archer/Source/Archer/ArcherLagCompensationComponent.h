@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ArcherLagCompensationComponent.generated.h"
+
+/** Sphere around a bone used to validate hits */
+USTRUCT(BlueprintType)
+struct FArcherHitbox
+{
+	GENERATED_BODY()
+
+	FArcherHitbox()
+	{
+	}
+
+	FArcherHitbox(FName InBoneName, float InRadius)
+		: BoneName(InBoneName)
+		, Radius(InRadius)
+	{
+	}
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lag Compensation")
+	FName BoneName;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Lag Compensation")
+	float Radius = 15.0f;
+};
+
+/**
+ * Server side history of where an archer's capsule and key bones were, used to check arrow hits
+ * against what the shooter saw when it fired.
+ * Frames are recorded at a fixed rate into a ring allocated once in BeginPlay, so recording never allocates
+ * and memory per archer is bounded by HistoryDuration * RecordRate.
+ */
+UCLASS(ClassGroup = Network, meta = (BlueprintSpawnableComponent))
+class ARCHER_API UArcherLagCompensationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UArcherLagCompensationComponent();
+
+	/** Seconds of history kept, shots from clients with more latency than this are checked against the oldest frame */
+	UPROPERTY(EditDefaultsOnly, Category = "Lag Compensation")
+	float HistoryDuration;
+
+	/** Frames recorded per second */
+	UPROPERTY(EditDefaultsOnly, Category = "Lag Compensation")
+	float RecordRate;
+
+	/** Bones recorded besides the capsule, bones missing from the skeleton are skipped */
+	UPROPERTY(EditDefaultsOnly, Category = "Lag Compensation")
+	TArray<FArcherHitbox> Hitboxes;
+
+	/** Extra distance allowed between an arrow and a hitbox, covers interpolation and quantization error */
+	UPROPERTY(EditDefaultsOnly, Category = "Lag Compensation")
+	float HitTolerance;
+
+	/** Rewind times are rounded to this many seconds, so arrows landing together share one rewound frame */
+	UPROPERTY(EditDefaultsOnly, Category = "Lag Compensation")
+	float RewindResolution;
+
+	/**
+	 * Sweep an arrow's movement against the archer's hitboxes as they were at server time Time
+	 * @param Time - server world time to rewind to
+	 * @param Start - where the arrow was at the start of the move that hit
+	 * @param End - where that move was headed
+	 * @param Radius - radius of the swept arrow
+	 * @param OutHit - impact location, normal, bone and time of the first hitbox the sweep enters, other fields are left as they are
+	 * @return true if the sweep went through the capsule or a bone hitbox, give or take HitTolerance
+	 */
+	bool ValidateHit(float Time, const FVector& Start, const FVector& End, float Radius, FHitResult& OutHit) const;
+
+	/**
+	 * Sweep an arrow's move against the rewound hitboxes of every archer near it, found through UArcherSpatialIndexSubsystem.
+	 * Lets the server grant hits the shooter saw on a past position that the arrow misses in the present
+	 * @param WorldContextObject - world to search
+	 * @param Time - server world time to rewind to
+	 * @param Start - where the arrow was at the start of the move
+	 * @param End - where the arrow is at the end of the move
+	 * @param Radius - radius of the swept arrow
+	 * @param QueryRadius - how far from the move archers are considered, covers their size and how far they moved since Time
+	 * @param IgnoredActor - usually the shooter
+	 * @param OutHit - first hitbox the move enters, with the archer as actor and its mesh or capsule as component
+	 * @return true if the move hit a rewound archer
+	 */
+	static bool SweepRewoundArchers(const UObject* WorldContextObject, float Time, const FVector& Start, const FVector& End, float Radius, float QueryRadius, const AActor* IgnoredActor, FHitResult& OutHit);
+
+	/** Seconds of history currently recorded */
+	float GetRecordedDuration() const;
+
+	virtual void BeginPlay() override;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	/** Hitbox positions at one point in time, interpolated between two recorded frames */
+	struct FRewoundFrame
+	{
+		/** Rewind time in steps of RewindResolution */
+		int64 Step;
+		FVector CapsuleLocation;
+		TArray<FVector, TInlineAllocator<8>> BoneLocations;
+	};
+
+	void RecordFrame();
+
+	/** Fill RewoundFrame with hitbox positions at Time, reuses the last result when asked for a time within the same RewindResolution step */
+	const FRewoundFrame& Rewind(float Time) const;
+
+	/** Ring slot of the Age-th newest frame */
+	FORCEINLINE int32 GetSlot(int32 Age) const { return (Head - 1 - Age + MaxFrames) % MaxFrames; }
+
+	// Ring of recorded frames, bones are stored flat with NumBones entries per frame
+	TArray<float> FrameTimes;
+	TArray<FVector> CapsuleLocations;
+	TArray<FVector> BoneLocations;
+	TArray<int32> BoneIndices;
+	TArray<float> BoneRadii;
+	TArray<FName> BoneNames;
+	int32 MaxFrames;
+	int32 NumFrames;
+	int32 Head;
+
+	float CapsuleRadius;
+	float CapsuleHalfHeight;
+
+	/** Last rewind result, many arrows landing in one frame mostly ask for the same times */
+	mutable FRewoundFrame RewoundFrame;
+	mutable bool bIsRewoundFrameValid;
+};
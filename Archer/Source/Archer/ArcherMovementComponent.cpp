@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherMovementComponent.h"
+#include "GameFramework/Character.h"
+
+UArcherMovementComponent::UArcherMovementComponent()
+{
+	RunSpeed = 375.f;
+	SprintSpeed = 562.5f;
+	SprintSpeedCrouched = 187.5f;
+	WalkSpeed = 180.5f;  //  93.75f;
+	WalkSpeedCrouched = 46.87f;
+	JumpWalkZVelocity = 375.f;
+	JumpRunZVelocity = 450.f;
+	JumpSprintZVelocity = 562.5f;
+
+	bWantsToWalk = false;
+	bWantsToSprint = false;
+	bWantsToAim = false;
+
+	// Defaults for code that reads the stock properties, GetMaxSpeed() and DoJump() use the tables above
+	MaxWalkSpeed = RunSpeed;
+	MaxWalkSpeedCrouched = WalkSpeedCrouched;
+	JumpZVelocity = JumpRunZVelocity;
+}
+
+float UArcherMovementComponent::GetMaxSpeed() const
+{
+	if (MovementMode != MOVE_Walking && MovementMode != MOVE_NavWalking)
+	{
+		return Super::GetMaxSpeed();
+	}
+
+	if (IsCrouching())
+	{
+		return IsSprinting() ? SprintSpeedCrouched : WalkSpeedCrouched;
+	}
+	if (IsWalkModeActive())
+	{
+		return WalkSpeed;
+	}
+	return IsSprinting() ? SprintSpeed : RunSpeed;
+}
+
+bool UArcherMovementComponent::CanAttemptJump() const
+{
+	return !bWantsToAim && Super::CanAttemptJump();
+}
+
+bool UArcherMovementComponent::DoJump(bool bReplayingMoves)
+{
+	JumpZVelocity = IsWalkModeActive() ? JumpWalkZVelocity : (IsSprinting() ? JumpSprintZVelocity : JumpRunZVelocity);
+
+	return Super::DoJump(bReplayingMoves);
+}
+
+void UArcherMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToWalk = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_1) != 0;
+	bWantsToAim = (Flags & FSavedMove_Character::FLAG_Custom_2) != 0;
+}
+
+FNetworkPredictionData_Client* UArcherMovementComponent::GetPredictionData_Client() const
+{
+	check(PawnOwner != NULL);
+
+	if (ClientPredictionData == NULL)
+	{
+		UArcherMovementComponent* MutableThis = const_cast<UArcherMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Archer(*this);
+	}
+	return ClientPredictionData;
+}
+
+void FSavedMove_Archer::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToWalk = false;
+	bSavedWantsToSprint = false;
+	bSavedWantsToAim = false;
+}
+
+uint8 FSavedMove_Archer::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+
+	if (bSavedWantsToWalk)
+	{
+		Result |= FLAG_Custom_0;
+	}
+	if (bSavedWantsToSprint)
+	{
+		Result |= FLAG_Custom_1;
+	}
+	if (bSavedWantsToAim)
+	{
+		Result |= FLAG_Custom_2;
+	}
+	return Result;
+}
+
+bool FSavedMove_Archer::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Archer* NewArcherMove = static_cast<const FSavedMove_Archer*>(NewMove.Get());
+	if (bSavedWantsToWalk != NewArcherMove->bSavedWantsToWalk
+		|| bSavedWantsToSprint != NewArcherMove->bSavedWantsToSprint
+		|| bSavedWantsToAim != NewArcherMove->bSavedWantsToAim)
+	{
+		return false;
+	}
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Archer::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	const UArcherMovementComponent* Movement = CastChecked<UArcherMovementComponent>(Character->GetCharacterMovement());
+	bSavedWantsToWalk = Movement->bWantsToWalk;
+	bSavedWantsToSprint = Movement->bWantsToSprint;
+	bSavedWantsToAim = Movement->bWantsToAim;
+}
+
+void FSavedMove_Archer::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+
+	UArcherMovementComponent* Movement = CastChecked<UArcherMovementComponent>(Character->GetCharacterMovement());
+	Movement->bWantsToWalk = bSavedWantsToWalk;
+	Movement->bWantsToSprint = bSavedWantsToSprint;
+	Movement->bWantsToAim = bSavedWantsToAim;
+}
+
+FNetworkPredictionData_Client_Archer::FNetworkPredictionData_Client_Archer(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Archer::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Archer());
+}
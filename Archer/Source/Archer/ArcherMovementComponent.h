@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ArcherMovementComponent.generated.h"
+
+/**
+ * Character movement with walk, sprint and aim modes.
+ * Modes are requested through flags that travel with every saved move, and speeds are looked up from them here,
+ * so the server runs the same numbers as the predicting client instead of correcting every speed change.
+ */
+UCLASS()
+class ARCHER_API UArcherMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UArcherMovementComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float RunSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float SprintSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float SprintSpeedCrouched;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float WalkSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float WalkSpeedCrouched;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float JumpWalkZVelocity;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float JumpRunZVelocity;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement: Archer")
+	float JumpSprintZVelocity;
+
+	/** Walk mode toggled on */
+	uint8 bWantsToWalk : 1;
+
+	/** Sprint held, ignored in walk mode and while aiming */
+	uint8 bWantsToSprint : 1;
+
+	/** Bow drawn, moves at walk speed and can't jump */
+	uint8 bWantsToAim : 1;
+
+	UFUNCTION(BlueprintPure, Category = "Character Movement: Archer")
+	bool IsWalkModeActive() const { return bWantsToWalk || bWantsToAim; }
+
+	UFUNCTION(BlueprintPure, Category = "Character Movement: Archer")
+	bool IsSprinting() const { return bWantsToSprint && !IsWalkModeActive(); }
+
+	virtual float GetMaxSpeed() const override;
+	virtual bool CanAttemptJump() const override;
+	virtual bool DoJump(bool bReplayingMoves) override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+};
+
+/** Saved move remembering the archer movement modes it was made with */
+class FSavedMove_Archer : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* Character) override;
+
+private:
+	uint8 bSavedWantsToWalk : 1;
+	uint8 bSavedWantsToSprint : 1;
+	uint8 bSavedWantsToAim : 1;
+};
+
+class FNetworkPredictionData_Client_Archer : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Archer(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
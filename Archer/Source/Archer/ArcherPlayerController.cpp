@@ -2,4 +2,128 @@
 
 
 #include "ArcherPlayerController.h"
+#include "ArcherCharacter.h"
+#include "ArcherSignificance.h"
+#include "GameFramework/PlayerInput.h"
 
+namespace ArcherPlayerController
+{
+	static const FName ShootAction(TEXT("Shoot"));
+}
+
+AArcherPlayerController::AArcherPlayerController()
+{
+	LastControlRotation = FRotator::ZeroRotator;
+	LastControlRotationTime = 0.0;
+	DeferredShotTime = 0.0;
+	bIsProcessingInput = false;
+	ReleasedShotAlpha = 0.0f;
+	ReleasedShotTimeAhead = 0.0f;
+	ReleasedShotFrame = 0;
+}
+
+bool AArcherPlayerController::InputKey(FKey Key, EInputEvent EventType, float AmountDepressed, bool bGamepad)
+{
+	// Platform messages are pumped before the world ticks, bound actions only run later in PlayerTick()
+	if (EventType == IE_Pressed || EventType == IE_Released)
+	{
+		KeyEventTimes.Add(Key, FPlatformTime::Seconds());
+	}
+
+	return Super::InputKey(Key, EventType, AmountDepressed, bGamepad);
+}
+
+void AArcherPlayerController::PlayerTick(float DeltaTime)
+{
+	// Runs input bindings first and applies this frame's look input after them
+	bIsProcessingInput = true;
+	Super::PlayerTick(DeltaTime);
+	bIsProcessingInput = false;
+
+	const double Now = FPlatformTime::Seconds();
+	if (DeferredShotTime > 0.0)
+	{
+		ReleaseDeferredShot(Now, DeltaTime);
+	}
+	LastControlRotation = GetControlRotation();
+	LastControlRotationTime = Now;
+
+	// Rank archers against this player's view so distant and hidden ones update less often
+	if (IsLocalController())
+	{
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		GetPlayerViewPoint(ViewLocation, ViewRotation);
+		ArcherSignificance::UpdateFromView(GetWorld(), ViewLocation, ViewRotation);
+	}
+}
+
+bool AArcherPlayerController::DeferShot()
+{
+	double ShotTime = 0.0;
+	if (!bIsProcessingInput || !IsLocalController() || !GetActionPressTime(ArcherPlayerController::ShootAction, ShotTime))
+	{
+		return false;
+	}
+
+	DeferredShotTime = ShotTime;
+	return true;
+}
+
+void AArcherPlayerController::ReleaseDeferredShot(double Now, float DeltaTime)
+{
+	const double ShotTime = DeferredShotTime;
+	DeferredShotTime = 0.0;
+
+	AArcherCharacter* Archer = Cast<AArcherCharacter>(GetPawn());
+	if (Archer == NULL)
+	{
+		return;
+	}
+
+	// Look input is spread evenly over the frame, take the view of the moment Shoot came in
+	const double FrameTime = Now - LastControlRotationTime;
+	const float Alpha = FrameTime > 0.0 ? FMath::Clamp(float((ShotTime - LastControlRotationTime) / FrameTime), 0.0f, 1.0f) : 1.0f;
+	const FRotator ReleaseRotation = FMath::Lerp(LastControlRotation, GetControlRotation(), Alpha);
+
+	// Arrow has been flying since then, in game time and never longer than the frame
+	const float TimeAhead = FMath::Clamp(float(Now - ShotTime) * GetActorTimeDilation(), 0.0f, DeltaTime);
+
+	Archer->ReleaseArrow(ReleaseRotation, TimeAhead);
+
+	ReleasedShotAlpha = Alpha;
+	ReleasedShotTimeAhead = TimeAhead;
+	ReleasedShotFrame = GFrameCounter;
+}
+
+bool AArcherPlayerController::GetReleasedShotTiming(float& OutAlpha, float& OutTimeAhead) const
+{
+	if (ReleasedShotFrame != GFrameCounter)
+	{
+		return false;
+	}
+
+	OutAlpha = ReleasedShotAlpha;
+	OutTimeAhead = ReleasedShotTimeAhead;
+	return true;
+}
+
+bool AArcherPlayerController::GetActionPressTime(FName ActionName, double& OutTime) const
+{
+	if (PlayerInput == NULL)
+	{
+		return false;
+	}
+
+	bool bFound = false;
+	for (const FInputActionKeyMapping& Mapping : PlayerInput->GetKeysForAction(ActionName))
+	{
+		const double* KeyTime = KeyEventTimes.Find(Mapping.Key);
+		if (KeyTime != NULL && *KeyTime >= LastControlRotationTime && WasInputKeyJustPressed(Mapping.Key) && (!bFound || *KeyTime > OutTime))
+		{
+			OutTime = *KeyTime;
+			bFound = true;
+		}
+	}
+	return bFound;
+}
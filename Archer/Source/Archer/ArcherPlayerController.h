@@ -7,11 +7,57 @@
 #include "ArcherPlayerController.generated.h"
 
 /**
- * 
+ * Player controller of archers. Stamps key presses with the time they came in from the platform,
+ * so shots are released with the view the player had at that moment instead of wherever the frame left it.
  */
 UCLASS()
 class ARCHER_API AArcherPlayerController : public APlayerController
 {
 	GENERATED_BODY()
-	
+
+public:
+	AArcherPlayerController();
+
+	virtual void PlayerTick(float DeltaTime) override;
+	virtual bool InputKey(FKey Key, EInputEvent EventType, float AmountDepressed, bool bGamepad) override;
+
+	/**
+	 * Hold back a shot fired by input until this frame's look input is applied. PlayerTick() then releases the arrow
+	 * with the control rotation interpolated to the moment the Shoot key came in, flown ahead by the time since.
+	 * @return false if the shot is not timed by this controller and the pawn should release it right away
+	 */
+	bool DeferShot();
+
+	/**
+	 * How the shot released this frame was timed, for input recording
+	 * @param OutAlpha - where the release was between the previous frame's control rotation and this one's
+	 * @param OutTimeAhead - seconds the arrow was flown ahead
+	 * @return false if no deferred shot was released this frame
+	 */
+	bool GetReleasedShotTiming(float& OutAlpha, float& OutTimeAhead) const;
+
+private:
+	/** Release the shot held back by DeferShot(), control rotation must be up to date */
+	void ReleaseDeferredShot(double Now, float DeltaTime);
+
+	/** Platform time a key bound to ActionName last went down, false if none did since the previous frame */
+	bool GetActionPressTime(FName ActionName, double& OutTime) const;
+
+	/** Platform time keys were last pressed or released */
+	TMap<FKey, double> KeyEventTimes;
+
+	/** Control rotation at the end of the previous frame, and platform time it was sampled at */
+	FRotator LastControlRotation;
+	double LastControlRotationTime;
+
+	/** Platform time the deferred shot was fired at, 0 when no shot is held back */
+	double DeferredShotTime;
+
+	/** True while bound input actions run, only then are shots deferred */
+	bool bIsProcessingInput;
+
+	/** Timing of the last deferred shot released and the frame it was released in */
+	float ReleasedShotAlpha;
+	float ReleasedShotTimeAhead;
+	uint64 ReleasedShotFrame;
 };
@@ -0,0 +1,339 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherReplicationGraph.h"
+#include "ArcherCharacter.h"
+#include "Projectile.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "ReplicationGraphTypes.h"
+
+UArcherReplicationGraphNode_Arrows::UArcherReplicationGraphNode_Arrows()
+{
+	CellSize = 5000.0f;
+	NearDistance = 0.0f;
+	CullDistance = 0.0f;
+	ConeCos = 1.0f;
+
+	// Cells are rebuilt once per frame, not once per connection
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UArcherReplicationGraphNode_Arrows::AddArrow(AProjectile* Arrow)
+{
+	Arrows.AddUnique(Arrow);
+}
+
+bool UArcherReplicationGraphNode_Arrows::RemoveArrow(AProjectile* Arrow)
+{
+	return Arrows.RemoveSingleSwap(Arrow, false) > 0;
+}
+
+void UArcherReplicationGraphNode_Arrows::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	AddArrow(CastChecked<AProjectile>(ActorInfo.Actor));
+}
+
+bool UArcherReplicationGraphNode_Arrows::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	return RemoveArrow(CastChecked<AProjectile>(ActorInfo.Actor));
+}
+
+void UArcherReplicationGraphNode_Arrows::NotifyResetAllNetworkActors()
+{
+	Arrows.Reset();
+	Cells.Reset();
+}
+
+void UArcherReplicationGraphNode_Arrows::PrepareForReplication()
+{
+	for (TPair<FIntPoint, TArray<AProjectile*>>& Cell : Cells)
+	{
+		Cell.Value.Reset();
+	}
+
+	for (AProjectile* Arrow : Arrows)
+	{
+		if (!Arrow->IsInPool())
+		{
+			const FVector Location = Arrow->GetActorLocation();
+			Cells.FindOrAdd(FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize))).Add(Arrow);
+		}
+	}
+
+	// Cells arrows have flown out of would pile up otherwise
+	for (auto It = Cells.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UArcherReplicationGraphNode_Arrows::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	const FVector ViewLocation = Params.Viewer.ViewLocation;
+	const UNetConnection* Connection = Params.ConnectionManager.NetConnection;
+	const float NearDistanceSquared = FMath::Square(NearDistance);
+	const float CullDistanceSquared = FMath::Square(CullDistance);
+
+	for (const TPair<FIntPoint, TArray<AProjectile*>>& Cell : Cells)
+	{
+		// No arrow of a cell out of reach can be relevant
+		const FBox2D CellBounds(FVector2D(Cell.Key) * CellSize, FVector2D(Cell.Key + FIntPoint(1, 1)) * CellSize);
+		if (CellBounds.ComputeSquaredDistanceToPoint(FVector2D(ViewLocation)) > CullDistanceSquared)
+		{
+			continue;
+		}
+
+		for (AProjectile* Arrow : Cell.Value)
+		{
+			// Owning client already shows its predicted arrow
+			if (Arrow->GetNetConnection() == Connection)
+			{
+				continue;
+			}
+
+			const FVector ToViewer = ViewLocation - Arrow->GetActorLocation();
+			const float DistanceSquared = ToViewer.SizeSquared();
+			if (DistanceSquared > CullDistanceSquared)
+			{
+				continue;
+			}
+
+			// Inside the cone when the angle between flight direction and viewer is small enough
+			const bool bIsInCone = (ToViewer | Arrow->GetVelocity().GetSafeNormal()) >= ConeCos * FMath::Sqrt(DistanceSquared);
+			if (DistanceSquared <= NearDistanceSquared || bIsInCone)
+			{
+				ReplicationActorList.Add(Arrow);
+			}
+		}
+	}
+
+	if (ReplicationActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+	}
+}
+
+void UArcherReplicationGraphNode_OwnerOnly::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	Actors.AddUnique(ActorInfo.Actor);
+}
+
+bool UArcherReplicationGraphNode_OwnerOnly::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	return Actors.RemoveSingleSwap(ActorInfo.Actor, false) > 0;
+}
+
+void UArcherReplicationGraphNode_OwnerOnly::NotifyResetAllNetworkActors()
+{
+	Actors.Reset();
+}
+
+void UArcherReplicationGraphNode_OwnerOnly::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	const UNetConnection* Connection = Params.ConnectionManager.NetConnection;
+	for (AActor* Actor : Actors)
+	{
+		// Walks up the owner chain to the owning player controller
+		if (Actor->GetNetConnection() == Connection)
+		{
+			ReplicationActorList.Add(Actor);
+		}
+	}
+
+	if (ReplicationActorList.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+	}
+}
+
+UArcherReplicationGraph::UArcherReplicationGraph()
+{
+	GridCellSize = 10000.0f;
+	GridSpatialBias = FVector2D(-WORLD_MAX * 0.5f, -WORLD_MAX * 0.5f);
+	CharacterCullDistance = 15000.0f;
+	ArrowNearDistance = 3000.0f;
+	ArrowCullDistance = 20000.0f;
+	ArrowConeHalfAngle = 30.0f;
+	ArrowCellSize = 5000.0f;
+	StuckArrowCullDistance = 5000.0f;
+
+	GridNode = NULL;
+	AlwaysRelevantNode = NULL;
+	ArrowNode = NULL;
+	OwnerOnlyNode = NULL;
+}
+
+void UArcherReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Anything not listed falls back to the AActor settings
+	FClassReplicationInfo DefaultInfo;
+	GlobalActorReplicationInfoMap.SetClassInfo(AActor::StaticClass(), DefaultInfo);
+
+	SetClassCullDistance(AArcherCharacter::StaticClass(), CharacterCullDistance);
+	// Grid only sees stuck arrows, flight relevancy is decided by the arrow node
+	SetClassCullDistance(AProjectile::StaticClass(), StuckArrowCullDistance);
+}
+
+void UArcherReplicationGraph::SetClassCullDistance(UClass* Class, float CullDistance)
+{
+	const AActor* ActorDefaults = Class->GetDefaultObject<AActor>();
+
+	FClassReplicationInfo ClassInfo;
+	ClassInfo.CullDistanceSquared = FMath::Square(CullDistance);
+	ClassInfo.ReplicationPeriodFrame = FMath::Max<uint32>(FMath::RoundToInt(NetDriver->NetServerMaxTickRate / ActorDefaults->NetUpdateFrequency), 1);
+	GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+}
+
+void UArcherReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	ArrowNode = CreateNewNode<UArcherReplicationGraphNode_Arrows>();
+	ArrowNode->NearDistance = ArrowNearDistance;
+	ArrowNode->CullDistance = ArrowCullDistance;
+	ArrowNode->ConeCos = FMath::Cos(FMath::DegreesToRadians(ArrowConeHalfAngle));
+	ArrowNode->CellSize = ArrowCellSize;
+	AddGlobalGraphNode(ArrowNode);
+
+	OwnerOnlyNode = CreateNewNode<UArcherReplicationGraphNode_OwnerOnly>();
+	AddGlobalGraphNode(OwnerOnlyNode);
+}
+
+void UArcherReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// Player controller, pawn and view target of the connection
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+UArcherReplicationGraph::EActorRouting UArcherReplicationGraph::GetActorRouting(const AActor* Actor) const
+{
+	if (Actor->IsA<AProjectile>())
+	{
+		return EActorRouting::Arrow;
+	}
+	if (Actor->IsA<APlayerController>())
+	{
+		return EActorRouting::NotRouted;
+	}
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		return EActorRouting::OwnerOnly;
+	}
+	if (Actor->bAlwaysRelevant || Actor->IsA<AInfo>())
+	{
+		return EActorRouting::AlwaysRelevant;
+	}
+	if (Actor->NetDormancy >= DORM_DormantAll)
+	{
+		return EActorRouting::SpatializeDormancy;
+	}
+	return Actor->IsRootComponentMovable() ? EActorRouting::SpatializeDynamic : EActorRouting::SpatializeStatic;
+}
+
+void UArcherReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetActorRouting(ActorInfo.Actor))
+	{
+	case EActorRouting::AlwaysRelevant:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EActorRouting::OwnerOnly:
+		OwnerOnlyNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EActorRouting::SpatializeStatic:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EActorRouting::SpatializeDynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EActorRouting::SpatializeDormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	case EActorRouting::Arrow:
+		GlobalInfo.Events.DormancyChange.RemoveAll(this);
+		GlobalInfo.Events.DormancyChange.AddUObject(this, &UArcherReplicationGraph::OnArrowDormancyChanged);
+		if (ActorInfo.Actor->NetDormancy >= DORM_DormantAll)
+		{
+			GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		}
+		else
+		{
+			ArrowNode->NotifyAddNetworkActor(ActorInfo);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void UArcherReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetActorRouting(ActorInfo.Actor))
+	{
+	case EActorRouting::AlwaysRelevant:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EActorRouting::OwnerOnly:
+		OwnerOnlyNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EActorRouting::SpatializeStatic:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EActorRouting::SpatializeDynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EActorRouting::SpatializeDormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	case EActorRouting::Arrow:
+		if (!ArrowNode->NotifyRemoveNetworkActor(ActorInfo, false))
+		{
+			GridNode->RemoveActor_Static(ActorInfo);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void UArcherReplicationGraph::OnArrowDormancyChanged(AActor* Actor, FGlobalActorReplicationInfo& GlobalInfo, ENetDormancy NewDormancy, ENetDormancy OldDormancy)
+{
+	AProjectile* Arrow = CastChecked<AProjectile>(Actor);
+	const FNewReplicatedActorInfo ActorInfo(Actor);
+
+	const bool bWasDormant = OldDormancy >= DORM_DormantAll;
+	const bool bIsDormant = NewDormancy >= DORM_DormantAll;
+	if (bIsDormant && !bWasDormant)
+	{
+		// Stuck or pooled arrow stays where it is, the grid culls it by distance and dormancy keeps it free
+		ArrowNode->RemoveArrow(Arrow);
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+	}
+	else if (!bIsDormant && bWasDormant)
+	{
+		GridNode->RemoveActor_Static(ActorInfo);
+		ArrowNode->AddArrow(Arrow);
+	}
+}
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "ArcherReplicationGraph.generated.h"
+
+class AProjectile;
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+
+/**
+ * Arrows in flight, relevant to a connection only when it is close to the arrow or inside a cone ahead of it.
+ * Stuck arrows go dormant and are handed over to the spatial grid, so this list only ever holds short-lived arrows.
+ * Arrows are bucketed in 2D cells once per frame, connections only test arrows of cells within CullDistance.
+ */
+UCLASS()
+class ARCHER_API UArcherReplicationGraphNode_Arrows : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UArcherReplicationGraphNode_Arrows();
+
+	/** Size of the cells arrows are bucketed in */
+	float CellSize;
+
+	/** Arrows closer than this are relevant whatever direction they fly in */
+	float NearDistance;
+
+	/** Arrows further than this are never relevant */
+	float CullDistance;
+
+	/** Cosine of the half angle of the cone ahead of the arrow */
+	float ConeCos;
+
+	void AddArrow(AProjectile* Arrow);
+
+	bool RemoveArrow(AProjectile* Arrow);
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+	TArray<AProjectile*> Arrows;
+
+	/** Arrows in play by cell, rebuilt in PrepareForReplication() */
+	TMap<FIntPoint, TArray<AProjectile*>> Cells;
+
+	/** Filled per connection while gathering, replicated before the next connection gathers */
+	FActorRepListRefView ReplicationActorList;
+};
+
+/**
+ * Actors only relevant to their owner, each connection gets those it owns.
+ * Ownership is checked while gathering, so actors spawned before they have an owner or handed to another one need no rerouting.
+ */
+UCLASS()
+class ARCHER_API UArcherReplicationGraphNode_OwnerOnly : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+	TArray<AActor*> Actors;
+
+	/** Filled per connection while gathering, replicated before the next connection gathers */
+	FActorRepListRefView ReplicationActorList;
+};
+
+/**
+ * Replication driver for dedicated servers.
+ * Characters and other moving actors are bucketed in a 2D grid, arrows in flight go through UArcherReplicationGraphNode_Arrows,
+ * owner only actors through UArcherReplicationGraphNode_OwnerOnly,
+ * so per connection cost depends on what is around the viewer rather than on player and arrow count.
+ */
+UCLASS(Transient, config = Engine)
+class ARCHER_API UArcherReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UArcherReplicationGraph();
+
+	/** Size of a spatial grid cell */
+	UPROPERTY(config)
+	float GridCellSize;
+
+	/** Grid starts here, keep it below the smallest X and Y actors can reach */
+	UPROPERTY(config)
+	FVector2D GridSpatialBias;
+
+	/** Characters further than this are not replicated */
+	UPROPERTY(config)
+	float CharacterCullDistance;
+
+	/** Arrows in flight closer than this are replicated whatever direction they fly in */
+	UPROPERTY(config)
+	float ArrowNearDistance;
+
+	/** Arrows in flight further than this are not replicated */
+	UPROPERTY(config)
+	float ArrowCullDistance;
+
+	/** Half angle in degrees of the cone ahead of an arrow in which it is replicated */
+	UPROPERTY(config)
+	float ArrowConeHalfAngle;
+
+	/** Size of the cells arrows in flight are bucketed in, connections skip cells further than ArrowCullDistance */
+	UPROPERTY(config)
+	float ArrowCellSize;
+
+	/** Stuck arrows further than this are not replicated */
+	UPROPERTY(config)
+	float StuckArrowCullDistance;
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+private:
+	enum class EActorRouting : uint8
+	{
+		/** Player controllers, the per connection node adds each connection's own with its pawn and view target */
+		NotRouted,
+		/** Only relevant to their owner, gathered for the owning connection by the owner only node */
+		OwnerOnly,
+		AlwaysRelevant,
+		SpatializeStatic,
+		SpatializeDynamic,
+		SpatializeDormancy,
+		Arrow
+	};
+
+	EActorRouting GetActorRouting(const AActor* Actor) const;
+
+	void SetClassCullDistance(UClass* Class, float CullDistance);
+
+	/** Move arrow between the flight node and the grid as it gets stuck and launched again */
+	void OnArrowDormancyChanged(AActor* Actor, FGlobalActorReplicationInfo& GlobalInfo, ENetDormancy NewDormancy, ENetDormancy OldDormancy);
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	UPROPERTY()
+	UArcherReplicationGraphNode_Arrows* ArrowNode;
+
+	UPROPERTY()
+	UArcherReplicationGraphNode_OwnerOnly* OwnerOnlyNode;
+};
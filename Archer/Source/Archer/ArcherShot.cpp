@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherShot.h"
+
+void FArcherShot::SetRotation(const FRotator& Rotation)
+{
+	Yaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+	Pitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+}
+
+FRotator FArcherShot::GetRotation() const
+{
+	return FRotator(FRotator::DecompressAxisFromShort(Pitch), FRotator::DecompressAxisFromShort(Yaw), 0.0f);
+}
+
+void FArcherShot::SetDrawStrength(float Strength)
+{
+	DrawStrength = uint8(FMath::RoundToInt(FMath::Clamp(Strength, 0.0f, 1.0f) * MAX_uint8));
+}
+
+float FArcherShot::GetDrawStrength() const
+{
+	return float(DrawStrength) / MAX_uint8;
+}
+
+bool FArcherShot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Origin.NetSerialize(Ar, Map, bOutSuccess);
+
+	Ar << Yaw;
+	Ar << Pitch;
+	Ar << DrawStrength;
+	Ar << ShotId;
+	Ar << Timestamp;
+
+	return true;
+}
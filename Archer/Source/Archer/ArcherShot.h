@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "ArcherShot.generated.h"
+
+/**
+ * Everything the server needs to fire an arrow on behalf of a client, packed to a few bytes.
+ * Direction goes as two 16 bit angles and draw strength as a byte; roll is meaningless for an arrow.
+ */
+USTRUCT()
+struct ARCHER_API FArcherShot
+{
+	GENERATED_BODY()
+
+	/** Where the arrow leaves the bow */
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	/** Server world time the shot was fired at, as seen by the client */
+	UPROPERTY()
+	float Timestamp = 0.0f;
+
+	/** Matches the server's answer to the arrow predicted on the client */
+	UPROPERTY()
+	uint8 ShotId = 0;
+
+	void SetRotation(const FRotator& Rotation);
+	FRotator GetRotation() const;
+
+	/** 0..1 fraction of full draw, scales launch speed */
+	void SetDrawStrength(float Strength);
+	float GetDrawStrength() const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+private:
+	UPROPERTY()
+	uint16 Yaw = 0;
+
+	UPROPERTY()
+	uint16 Pitch = 0;
+
+	UPROPERTY()
+	uint8 DrawStrength = MAX_uint8;
+};
+
+template<>
+struct TStructOpsTypeTraits<FArcherShot> : public TStructOpsTypeTraitsBase2<FArcherShot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
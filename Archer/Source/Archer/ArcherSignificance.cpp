@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherSignificance.h"
+#include "ArcherCharacter.h"
+#include "SignificanceManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+const FName ArcherSignificance::Tag(TEXT("Archer"));
+
+UArcherSignificanceSettings::UArcherSignificanceSettings()
+{
+	FullDistance = 1500.0f;
+	MediumDistance = 4000.0f;
+	MinimalDistance = 10000.0f;
+	VisibilityTimeout = 0.5f;
+
+	AnimationTickIntervals = { 1.0f / 5.0f, 1.0f / 15.0f, 1.0f / 30.0f, 0.0f };
+	MovementTickIntervals = { 1.0f / 10.0f, 1.0f / 20.0f, 1.0f / 30.0f, 0.0f };
+}
+
+namespace ArcherSignificance
+{
+	static float CalculateSignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint)
+	{
+		const AArcherCharacter* Archer = CastChecked<AArcherCharacter>(ObjectInfo->GetObject());
+		// Bots are locally controlled on the server too, only the player's own archer is always significant
+		if (Archer->IsLocallyControlled() && Archer->IsPlayerControlled())
+		{
+			return float(EArcherSignificance::Full);
+		}
+
+		const UArcherSignificanceSettings* Settings = GetDefault<UArcherSignificanceSettings>();
+		const float DistanceSquared = FVector::DistSquared(Archer->GetActorLocation(), Viewpoint.GetLocation());
+		const bool bIsVisible = Archer->GetMesh()->WasRecentlyRendered(Settings->VisibilityTimeout);
+
+		EArcherSignificance Significance = EArcherSignificance::Low;
+		if (bIsVisible && DistanceSquared < FMath::Square(Settings->FullDistance))
+		{
+			Significance = EArcherSignificance::Full;
+		}
+		else if (bIsVisible && DistanceSquared < FMath::Square(Settings->MediumDistance))
+		{
+			Significance = EArcherSignificance::Medium;
+		}
+		else if (!bIsVisible && DistanceSquared > FMath::Square(Settings->MinimalDistance))
+		{
+			Significance = EArcherSignificance::Minimal;
+		}
+
+		// Drawn bow is what other players watch for, keep it smooth
+		if (Archer->bIsAiming && Significance < EArcherSignificance::Medium)
+		{
+			Significance = EArcherSignificance::Medium;
+		}
+
+		return float(Significance);
+	}
+
+	static void PostSignificanceChange(USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float NewSignificance, bool bFinal)
+	{
+		if (OldSignificance != NewSignificance)
+		{
+			AArcherCharacter* Archer = CastChecked<AArcherCharacter>(ObjectInfo->GetObject());
+			Archer->ApplySignificance(EArcherSignificance(FMath::RoundToInt(NewSignificance)));
+		}
+	}
+
+	void Register(AArcherCharacter* Archer)
+	{
+		USignificanceManager* SignificanceManager = USignificanceManager::Get(Archer->GetWorld());
+		if (SignificanceManager != NULL)
+		{
+			SignificanceManager->RegisterObject(Archer, Tag, &CalculateSignificance, EPostSignificanceType::Sequential, &PostSignificanceChange);
+		}
+	}
+
+	void Unregister(AArcherCharacter* Archer)
+	{
+		USignificanceManager* SignificanceManager = USignificanceManager::Get(Archer->GetWorld());
+		if (SignificanceManager != NULL)
+		{
+			SignificanceManager->UnregisterObject(Archer);
+		}
+	}
+
+	void UpdateFromView(UWorld* World, const FVector& ViewLocation, const FRotator& ViewRotation)
+	{
+		USignificanceManager* SignificanceManager = USignificanceManager::Get(World);
+		if (SignificanceManager != NULL)
+		{
+			const FTransform Viewpoint(ViewRotation, ViewLocation);
+			SignificanceManager->Update(TArrayView<const FTransform>(&Viewpoint, 1));
+		}
+	}
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "ArcherSignificance.generated.h"
+
+class AArcherCharacter;
+
+/** How much update budget an archer gets, higher is more */
+UENUM(BlueprintType)
+enum class EArcherSignificance : uint8
+{
+	/** Far away and not rendered */
+	Minimal,
+	/** Far away, or out of view */
+	Low,
+	/** Visible at medium range, or aiming */
+	Medium,
+	/** Close, or controlled by a local player */
+	Full
+};
+
+/**
+ * Distances and update rates used to scale archer update cost with significance.
+ * Index N of the interval arrays is used for EArcherSignificance N.
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Archer Significance"))
+class ARCHER_API UArcherSignificanceSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UArcherSignificanceSettings();
+
+	/** Archers closer than this are updated at full rate */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	float FullDistance;
+
+	/** Visible archers closer than this (or aiming ones) are updated at medium rate */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	float MediumDistance;
+
+	/** Archers further than this that are not rendered get the minimal rate */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	float MinimalDistance;
+
+	/** Seconds since last render after which an archer counts as out of view */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	float VisibilityTimeout;
+
+	/** Skeletal mesh tick interval per significance, 0 ticks every frame */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	TArray<float> AnimationTickIntervals;
+
+	/** Character movement tick interval per significance, only used for archers not controlled locally */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	TArray<float> MovementTickIntervals;
+};
+
+/** Registers archers with the significance manager and applies update rates when their significance changes */
+namespace ArcherSignificance
+{
+	/** Tag archers are registered under */
+	extern ARCHER_API const FName Tag;
+
+	void Register(AArcherCharacter* Archer);
+
+	void Unregister(AArcherCharacter* Archer);
+
+	/** Feed the significance manager of World with the view of a local player, call once per frame */
+	void UpdateFromView(UWorld* World, const FVector& ViewLocation, const FRotator& ViewRotation);
+}
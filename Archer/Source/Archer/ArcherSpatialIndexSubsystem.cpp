@@ -0,0 +1,274 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherSpatialIndexSubsystem.h"
+#include "Archer.h"
+#include "ArcherCharacter.h"
+
+UArcherSpatialIndexSubsystem::UArcherSpatialIndexSubsystem()
+{
+	CellSize = 1000.0f;
+}
+
+void UArcherSpatialIndexSubsystem::Register(AArcherCharacter* Archer)
+{
+	if (Archer == NULL || EntryIndices.Contains(Archer))
+	{
+		return;
+	}
+
+	FEntry Entry;
+	Entry.Archer = Archer;
+	Entry.Key = Archer;
+	Entry.Location = Archer->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+
+	const int32 EntryIndex = Entries.Add(Entry);
+	EntryIndices.Add(Archer, EntryIndex);
+	AddToCell(Entry.Cell, EntryIndex);
+
+	SET_DWORD_STAT(STAT_IndexedArchers, Entries.Num());
+}
+
+void UArcherSpatialIndexSubsystem::Unregister(AArcherCharacter* Archer)
+{
+	int32 EntryIndex = INDEX_NONE;
+	if (EntryIndices.RemoveAndCopyValue(Archer, EntryIndex))
+	{
+		RemoveEntry(EntryIndex);
+	}
+
+	SET_DWORD_STAT(STAT_IndexedArchers, Entries.Num());
+}
+
+void UArcherSpatialIndexSubsystem::Tick(float DeltaTime)
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherSpatialIndexUpdate);
+
+	// Walk backwards so swap-removal doesn't skip entries
+	for (int32 EntryIndex = Entries.Num() - 1; EntryIndex >= 0; --EntryIndex)
+	{
+		FEntry& Entry = Entries[EntryIndex];
+		const AArcherCharacter* Archer = Entry.Archer.Get();
+		if (Archer == NULL)
+		{
+			// Gone without unregistering
+			EntryIndices.Remove(Entry.Key);
+			RemoveEntry(EntryIndex);
+			continue;
+		}
+
+		Entry.Location = Archer->GetActorLocation();
+
+		// Cells only change when an archer crosses a border, most frames touch no cell at all
+		const FIntPoint NewCell = GetCell(Entry.Location);
+		if (NewCell != Entry.Cell)
+		{
+			RemoveFromCell(Entry.Cell, EntryIndex);
+			AddToCell(NewCell, EntryIndex);
+			Entry.Cell = NewCell;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_IndexedArchers, Entries.Num());
+}
+
+template<typename VisitorType>
+void UArcherSpatialIndexSubsystem::ForEachEntryInBounds(const FBox& Bounds, VisitorType Visitor) const
+{
+	const FIntPoint MinCell = GetCell(Bounds.Min);
+	const FIntPoint MaxCell = GetCell(Bounds.Max);
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+			if (Cell == NULL)
+			{
+				continue;
+			}
+
+			for (int32 EntryIndex : *Cell)
+			{
+				const FEntry& Entry = Entries[EntryIndex];
+				AArcherCharacter* Archer = Entry.Archer.Get();
+				if (Archer != NULL && !Archer->IsPendingKill())
+				{
+					Visitor(Archer, Entry.Location);
+				}
+			}
+		}
+	}
+}
+
+void UArcherSpatialIndexSubsystem::QueryCone(const FVector& Origin, const FVector& Direction, float MaxDistance, float HalfAngle, const AActor* IgnoredActor, TArray<AArcherCharacter*>& OutArchers) const
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherSpatialIndexQuery);
+
+	OutArchers.Reset();
+
+	const FVector Axis = Direction.GetSafeNormal();
+	if (Axis.IsZero() || MaxDistance <= 0.0f)
+	{
+		return;
+	}
+
+	// Bounds of apex and base disc, wide cones fall back to the sphere around the apex
+	FBox Bounds;
+	const float CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(HalfAngle, 0.0f, 180.0f)));
+	if (HalfAngle < 90.0f)
+	{
+		const FVector BaseCenter = Origin + Axis * MaxDistance;
+		const float BaseRadius = MaxDistance * FMath::Tan(FMath::DegreesToRadians(FMath::Max(HalfAngle, 0.0f)));
+		const FVector BaseExtent = BaseRadius * FVector(
+			FMath::Sqrt(FMath::Max(1.0f - Axis.X * Axis.X, 0.0f)),
+			FMath::Sqrt(FMath::Max(1.0f - Axis.Y * Axis.Y, 0.0f)),
+			FMath::Sqrt(FMath::Max(1.0f - Axis.Z * Axis.Z, 0.0f)));
+		Bounds = FBox(BaseCenter - BaseExtent, BaseCenter + BaseExtent);
+		Bounds += Origin;
+	}
+	else
+	{
+		Bounds = FBox(Origin - FVector(MaxDistance), Origin + FVector(MaxDistance));
+	}
+
+	// Closest to the axis first, the cosine to the axis is the sort key
+	TArray<TPair<float, AArcherCharacter*>, TInlineAllocator<16>> Found;
+	const float MaxDistanceSquared = FMath::Square(MaxDistance);
+	ForEachEntryInBounds(Bounds, [&](AArcherCharacter* Archer, const FVector& Location)
+	{
+		const FVector ToArcher = Location - Origin;
+		const float DistanceSquared = ToArcher.SizeSquared();
+		if (Archer == IgnoredActor || DistanceSquared > MaxDistanceSquared || DistanceSquared <= SMALL_NUMBER)
+		{
+			return;
+		}
+
+		const float CosAngle = (ToArcher | Axis) * FMath::InvSqrt(DistanceSquared);
+		if (CosAngle >= CosHalfAngle)
+		{
+			Found.Emplace(CosAngle, Archer);
+		}
+	});
+
+	Found.Sort([](const TPair<float, AArcherCharacter*>& A, const TPair<float, AArcherCharacter*>& B) { return A.Key > B.Key; });
+	OutArchers.Reserve(Found.Num());
+	for (const TPair<float, AArcherCharacter*>& Pair : Found)
+	{
+		OutArchers.Add(Pair.Value);
+	}
+}
+
+void UArcherSpatialIndexSubsystem::QuerySegment(const FVector& Start, const FVector& End, float Radius, const AActor* IgnoredActor, TArray<AArcherCharacter*>& OutArchers) const
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherSpatialIndexQuery);
+
+	OutArchers.Reset();
+
+	FBox Bounds(Start, Start);
+	Bounds += End;
+	const float RadiusSquared = FMath::Square(Radius);
+	ForEachEntryInBounds(Bounds.ExpandBy(Radius), [&](AArcherCharacter* Archer, const FVector& Location)
+	{
+		if (Archer != IgnoredActor && FMath::PointDistToSegmentSquared(Location, Start, End) <= RadiusSquared)
+		{
+			OutArchers.Add(Archer);
+		}
+	});
+}
+
+AArcherCharacter* UArcherSpatialIndexSubsystem::FindTargetInCone(const FVector& Origin, const FVector& Direction, float MaxDistance, float HalfAngle, const AActor* IgnoredActor) const
+{
+	TArray<AArcherCharacter*> Archers;
+	QueryCone(Origin, Direction, MaxDistance, HalfAngle, IgnoredActor, Archers);
+	return Archers.Num() > 0 ? Archers[0] : NULL;
+}
+
+AArcherCharacter* UArcherSpatialIndexSubsystem::FindNearest(const FVector& Location, float Radius, const AActor* IgnoredActor) const
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArcherSpatialIndexQuery);
+
+	float BestDistanceSquared = FMath::Square(Radius);
+	AArcherCharacter* BestArcher = NULL;
+
+	ForEachEntryInBounds(FBox(Location - FVector(Radius), Location + FVector(Radius)), [&](AArcherCharacter* Archer, const FVector& ArcherLocation)
+	{
+		const float DistanceSquared = FVector::DistSquared(Location, ArcherLocation);
+		if (Archer != IgnoredActor && DistanceSquared < BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			BestArcher = Archer;
+		}
+	});
+	return BestArcher;
+}
+
+FIntPoint UArcherSpatialIndexSubsystem::GetCell(const FVector& Location) const
+{
+	const float InvCellSize = 1.0f / FMath::Max(CellSize, 1.0f);
+	return FIntPoint(FMath::FloorToInt(Location.X * InvCellSize), FMath::FloorToInt(Location.Y * InvCellSize));
+}
+
+void UArcherSpatialIndexSubsystem::AddToCell(const FIntPoint& Cell, int32 EntryIndex)
+{
+	Cells.FindOrAdd(Cell).Add(EntryIndex);
+}
+
+void UArcherSpatialIndexSubsystem::RemoveFromCell(const FIntPoint& Cell, int32 EntryIndex)
+{
+	TArray<int32>* CellEntries = Cells.Find(Cell);
+	if (CellEntries == NULL)
+	{
+		return;
+	}
+
+	CellEntries->RemoveSingleSwap(EntryIndex, false);
+	if (CellEntries->Num() == 0)
+	{
+		Cells.Remove(Cell);
+	}
+}
+
+void UArcherSpatialIndexSubsystem::RemoveEntry(int32 EntryIndex)
+{
+	RemoveFromCell(Entries[EntryIndex].Cell, EntryIndex);
+
+	// Last entry moves into the gap, point its cell and lookup at the new index
+	const int32 LastIndex = Entries.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		const FEntry& LastEntry = Entries[LastIndex];
+		TArray<int32>& LastCell = Cells.FindChecked(LastEntry.Cell);
+		LastCell[LastCell.IndexOfByKey(LastIndex)] = EntryIndex;
+		if (int32* LastEntryIndex = EntryIndices.Find(LastEntry.Key))
+		{
+			*LastEntryIndex = EntryIndex;
+		}
+	}
+	Entries.RemoveAtSwap(EntryIndex, 1, false);
+}
+
+bool UArcherSpatialIndexSubsystem::IsTickable() const
+{
+	return Entries.Num() > 0;
+}
+
+ETickableTickType UArcherSpatialIndexSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UArcherSpatialIndexSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UArcherSpatialIndexSubsystem, STATGROUP_Tickables);
+}
+
+void UArcherSpatialIndexSubsystem::ResetWorldState()
+{
+	Entries.Reset();
+	Cells.Reset();
+	EntryIndices.Reset();
+
+	SET_DWORD_STAT(STAT_IndexedArchers, 0);
+}
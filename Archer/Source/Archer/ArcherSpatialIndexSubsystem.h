@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArcherSpatialIndexSubsystem.generated.h"
+
+class AArcherCharacter;
+
+/**
+ * Uniform grid over the XY plane holding every archer of the world, for target acquisition without iterating pawns
+ * or running overlap queries. Archers register themselves on BeginPlay; once a frame their positions are read back and
+ * only archers that crossed into another cell are moved. Queries visit just the cells their shape covers,
+ * so their cost follows how crowded the queried area is rather than how many archers the world has.
+ * Positions are those at the end of the previous frame.
+ */
+UCLASS(config = Game)
+class ARCHER_API UArcherSpatialIndexSubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UArcherSpatialIndexSubsystem();
+
+	/** Edge length of a grid cell, about the radius most queries use */
+	UPROPERTY(config, EditAnywhere, Category = "Spatial Index")
+	float CellSize;
+
+	void Register(AArcherCharacter* Archer);
+	void Unregister(AArcherCharacter* Archer);
+
+	/** Returns number of archers in the index */
+	int32 GetNumArchers() const { return Entries.Num(); }
+
+	/**
+	 * Collect archers inside a cone, for aim assist and hit marker prediction
+	 * @param Origin - cone apex, usually where the arrow is released
+	 * @param Direction - cone axis, usually the aim
+	 * @param MaxDistance - cone length
+	 * @param HalfAngle - degrees between the axis and the side of the cone
+	 * @param IgnoredActor - archer that is asking, left out of the results
+	 * @param OutArchers - archers in the cone, closest to the axis first
+	 */
+	void QueryCone(const FVector& Origin, const FVector& Direction, float MaxDistance, float HalfAngle, const AActor* IgnoredActor, TArray<AArcherCharacter*>& OutArchers) const;
+
+	/**
+	 * Collect archers near a line segment, for sweeping arrow moves against lag compensated hitboxes
+	 * @param Start - segment start
+	 * @param End - segment end
+	 * @param Radius - largest distance between an archer's location and the segment
+	 * @param IgnoredActor - usually the shooter, left out of the results
+	 * @param OutArchers - archers near the segment, in no particular order
+	 */
+	void QuerySegment(const FVector& Start, const FVector& End, float Radius, const AActor* IgnoredActor, TArray<AArcherCharacter*>& OutArchers) const;
+
+	/** Archer in the cone closest to its axis, NULL if the cone is empty. See QueryCone() */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Index")
+	AArcherCharacter* FindTargetInCone(const FVector& Origin, const FVector& Direction, float MaxDistance, float HalfAngle, const AActor* IgnoredActor) const;
+
+	/** Closest archer within Radius of Location, NULL if there is none */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Index")
+	AArcherCharacter* FindNearest(const FVector& Location, float Radius, const AActor* IgnoredActor) const;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<AArcherCharacter> Archer;
+		/** Key of EntryIndices, still valid as a key once the archer is gone */
+		const AArcherCharacter* Key;
+		FVector Location;
+		FIntPoint Cell;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	/** Call Visitor with every live entry in cells overlapping Bounds */
+	template<typename VisitorType>
+	void ForEachEntryInBounds(const FBox& Bounds, VisitorType Visitor) const;
+
+	void AddToCell(const FIntPoint& Cell, int32 EntryIndex);
+	void RemoveFromCell(const FIntPoint& Cell, int32 EntryIndex);
+
+	/** Swap-remove entry, the last entry takes its index */
+	void RemoveEntry(int32 EntryIndex);
+
+	TArray<FEntry> Entries;
+
+	/** Indices into Entries of the archers in each occupied cell */
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	/** Entries index by archer, for unregistering */
+	TMap<const AArcherCharacter*, int32> EntryIndices;
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArcherWorldSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+void UArcherWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &UArcherWorldSubsystem::OnWorldCleanup);
+}
+
+void UArcherWorldSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	ResetWorldState();
+
+	Super::Deinitialize();
+}
+
+UWorld* UArcherWorldSubsystem::GetWorld() const
+{
+	const UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetWorld() : nullptr;
+}
+
+void UArcherWorldSubsystem::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	// Other worlds (editor preview, streaming) are not ours to track
+	if (World != NULL && World == GetWorld())
+	{
+		ResetWorldState();
+	}
+}
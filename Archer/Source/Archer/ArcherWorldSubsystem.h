@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "ArcherWorldSubsystem.generated.h"
+
+/**
+ * Base for archer gameplay services that hold state for the world currently owned by the game instance.
+ * State is dropped through ResetWorldState() whenever that world is cleaned up (map travel, end of PIE).
+ */
+UCLASS(Abstract)
+class ARCHER_API UArcherWorldSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual UWorld* GetWorld() const override;
+
+	/** Returns subsystem of given class for the world of WorldContextObject, nullptr if the world has no game instance */
+	template<class T>
+	static T* Get(const UObject* WorldContextObject)
+	{
+		UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		return GameInstance ? GameInstance->GetSubsystem<T>() : nullptr;
+	}
+
+protected:
+	/** Called when the world of the game instance is cleaned up, release everything that references it */
+	virtual void ResetWorldState() {}
+
+private:
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+
+	FDelegateHandle WorldCleanupHandle;
+};
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArrowImpulseSubsystem.h"
+#include "Archer.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+
+void FArrowImpulseFlushTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (ImpulseSubsystem != NULL)
+	{
+		ImpulseSubsystem->Flush();
+	}
+}
+
+FString FArrowImpulseFlushTickFunction::DiagnosticMessage()
+{
+	return TEXT("ArrowImpulseSubsystem[Flush]");
+}
+
+UArrowImpulseSubsystem::UArrowImpulseSubsystem()
+{
+	NumQueuedImpulses = 0;
+}
+
+void UArrowImpulseSubsystem::Deinitialize()
+{
+	UnregisterFlushTick();
+
+	Super::Deinitialize();
+}
+
+void UArrowImpulseSubsystem::QueueImpulse(UPrimitiveComponent* Component, FName BoneName, const FVector& Impulse, const FVector& Location)
+{
+	UWorld* const World = GetWorld();
+	if (Component == NULL || World == NULL || !Component->IsSimulatingPhysics(BoneName))
+	{
+		return;
+	}
+
+	if (!FlushTickFunction.IsTickFunctionRegistered())
+	{
+		RegisterFlushTick(World);
+	}
+
+	const TPair<UPrimitiveComponent*, FName> BodyKey(Component, BoneName);
+	int32* ExistingIndex = PendingImpulseIndices.Find(BodyKey);
+	FPendingImpulse& Pending = ExistingIndex != NULL ? PendingImpulses[*ExistingIndex] : PendingImpulses[PendingImpulseIndices.Add(BodyKey, PendingImpulses.AddZeroed())];
+	Pending.Component = Component;
+	Pending.BoneName = BoneName;
+
+	// Impulse off the center of mass is the same impulse through it plus a spin, both of which simply add up
+	Pending.LinearImpulse += Impulse;
+	Pending.AngularImpulse += (Location - Component->GetCenterOfMass(BoneName)) ^ Impulse;
+
+	++NumQueuedImpulses;
+}
+
+void UArrowImpulseSubsystem::Flush()
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowImpulseFlush);
+
+	SET_DWORD_STAT(STAT_ArrowImpulsesMerged, NumQueuedImpulses);
+	SET_DWORD_STAT(STAT_ArrowImpulseBodies, PendingImpulses.Num());
+
+	for (const FPendingImpulse& Pending : PendingImpulses)
+	{
+		UPrimitiveComponent* Component = Pending.Component.Get();
+		if (Component != NULL && Component->IsSimulatingPhysics(Pending.BoneName))
+		{
+			Component->AddImpulse(Pending.LinearImpulse, Pending.BoneName);
+			Component->AddAngularImpulseInRadians(Pending.AngularImpulse, Pending.BoneName);
+		}
+	}
+
+	// Keep allocations, volleys come in waves
+	PendingImpulses.Reset();
+	PendingImpulseIndices.Reset();
+	NumQueuedImpulses = 0;
+}
+
+void UArrowImpulseSubsystem::ResetWorldState()
+{
+	UnregisterFlushTick();
+
+	PendingImpulses.Reset();
+	PendingImpulseIndices.Reset();
+	NumQueuedImpulses = 0;
+}
+
+void UArrowImpulseSubsystem::RegisterFlushTick(UWorld* World)
+{
+	FlushTickFunction.ImpulseSubsystem = this;
+	FlushTickFunction.TickGroup = TG_StartPhysics;
+	FlushTickFunction.bCanEverTick = true;
+	FlushTickFunction.RegisterTickFunction(World->PersistentLevel);
+
+	// Physics step starts only after the flush, so nothing is pushed while the scene simulates
+	World->StartPhysicsTickFunction.AddPrerequisite(this, FlushTickFunction);
+	FlushTickWorld = World;
+}
+
+void UArrowImpulseSubsystem::UnregisterFlushTick()
+{
+	if (!FlushTickFunction.IsTickFunctionRegistered())
+	{
+		return;
+	}
+
+	if (UWorld* World = FlushTickWorld.Get())
+	{
+		World->StartPhysicsTickFunction.RemovePrerequisite(this, FlushTickFunction);
+	}
+	FlushTickFunction.UnRegisterTickFunction();
+	FlushTickWorld.Reset();
+}
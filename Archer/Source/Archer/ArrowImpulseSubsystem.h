@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArrowImpulseSubsystem.generated.h"
+
+class UArrowImpulseSubsystem;
+class UPrimitiveComponent;
+
+/** Applies queued arrow impulses right before the physics scene steps */
+USTRUCT()
+struct FArrowImpulseFlushTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UArrowImpulseSubsystem* ImpulseSubsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FArrowImpulseFlushTickFunction> : public TStructOpsTypeTraitsBase2<FArrowImpulseFlushTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Collects impulses of arrow hits during the frame instead of pushing bodies from inside hit callbacks.
+ * Impulses on the same body are merged into one linear and one angular impulse about its center of mass,
+ * which moves the body exactly like the separate impulses would. Everything is applied in one pass before
+ * the physics scene starts its step, impulses queued later in the frame go out with the next step.
+ */
+UCLASS()
+class ARCHER_API UArrowImpulseSubsystem : public UArcherWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UArrowImpulseSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Push a body at the next physics step
+	 * @param Component - component that was hit, ignored unless it simulates physics
+	 * @param BoneName - body of Component that was hit, NAME_None for single body components
+	 * @param Impulse - impulse in world space
+	 * @param Location - world location the impulse is applied at
+	 */
+	void QueueImpulse(UPrimitiveComponent* Component, FName BoneName, const FVector& Impulse, const FVector& Location);
+
+	/** Apply and clear all queued impulses */
+	void Flush();
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	struct FPendingImpulse
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		FName BoneName;
+		FVector LinearImpulse;
+		/** Angular impulse about the body's center of mass, in radians */
+		FVector AngularImpulse;
+	};
+
+	void RegisterFlushTick(UWorld* World);
+	void UnregisterFlushTick();
+
+	/** Queued impulses, one per body */
+	TArray<FPendingImpulse> PendingImpulses;
+
+	/** Index into PendingImpulses by body */
+	TMap<TPair<UPrimitiveComponent*, FName>, int32> PendingImpulseIndices;
+
+	/** Impulses queued since the last flush, before merging */
+	int32 NumQueuedImpulses;
+
+	FArrowImpulseFlushTickFunction FlushTickFunction;
+
+	/** World whose StartPhysicsTickFunction waits for FlushTickFunction */
+	TWeakObjectPtr<UWorld> FlushTickWorld;
+};
@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArrowInstanceRenderer.h"
+#include "Archer.h"
+#include "Projectile.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+static void LogArrowInstanceCounts(UWorld* World)
+{
+	bool bFoundRenderer = false;
+	for (TActorIterator<AArrowInstanceRenderer> It(World); It; ++It)
+	{
+		It->LogInstanceCounts();
+		bFoundRenderer = true;
+	}
+
+	if (!bFoundRenderer)
+	{
+		UE_LOG(LogArcher, Display, TEXT("No arrows are drawn as instances"));
+	}
+}
+
+static FAutoConsoleCommandWithWorld LogArrowInstanceCountsCommand(
+	TEXT("Archer.ArrowInstances"),
+	TEXT("Log number of arrows drawn through instanced meshes"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogArrowInstanceCounts));
+
+AArrowInstanceRenderer::AArrowInstanceRenderer()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Arrows have moved by now, commit their transforms before the frame is rendered
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+AArrowInstanceRenderer* AArrowInstanceRenderer::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	if (World == NULL)
+	{
+		return nullptr;
+	}
+
+	for (TActorIterator<AArrowInstanceRenderer> It(World); It; ++It)
+	{
+		if (!It->IsPendingKill())
+		{
+			return *It;
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<AArrowInstanceRenderer>(SpawnParams);
+}
+
+int32 AArrowInstanceRenderer::AddInstance(UStaticMesh* Mesh, const FTransform& Transform, bool bStatic)
+{
+	if (Mesh == NULL)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 BatchIndex = FindOrAddBatch(Mesh, bStatic);
+	FInstanceBatch& Batch = Batches[BatchIndex];
+
+	FInstanceRecord Record;
+	Record.BatchIndex = BatchIndex;
+	Record.DenseIndex = Batch.Transforms.Add(Transform);
+	const int32 InstanceId = Instances.Add(Record);
+
+	Batch.InstanceIds.Add(InstanceId);
+	MarkDirty(Batch, Record.DenseIndex);
+
+	return InstanceId;
+}
+
+void AArrowInstanceRenderer::UpdateInstance(int32 InstanceId, const FTransform& Transform)
+{
+	if (!Instances.IsValidIndex(InstanceId))
+	{
+		return;
+	}
+
+	const FInstanceRecord& Record = Instances[InstanceId];
+	FInstanceBatch& Batch = Batches[Record.BatchIndex];
+	Batch.Transforms[Record.DenseIndex] = Transform;
+	MarkDirty(Batch, Record.DenseIndex);
+}
+
+void AArrowInstanceRenderer::RemoveInstance(int32 InstanceId)
+{
+	if (!Instances.IsValidIndex(InstanceId))
+	{
+		return;
+	}
+
+	const FInstanceRecord Record = Instances[InstanceId];
+	Instances.RemoveAt(InstanceId);
+
+	FInstanceBatch& Batch = Batches[Record.BatchIndex];
+	const int32 LastIndex = Batch.Transforms.Num() - 1;
+	if (Record.DenseIndex != LastIndex)
+	{
+		// Last instance fills the hole, only that slot is rewritten and the component drops its last instance
+		Batch.Transforms[Record.DenseIndex] = Batch.Transforms[LastIndex];
+		Batch.InstanceIds[Record.DenseIndex] = Batch.InstanceIds[LastIndex];
+		Instances[Batch.InstanceIds[Record.DenseIndex]].DenseIndex = Record.DenseIndex;
+	}
+	Batch.Transforms.RemoveAt(LastIndex, 1, false);
+	Batch.InstanceIds.RemoveAt(LastIndex, 1, false);
+	MarkDirty(Batch, Record.DenseIndex);
+}
+
+void AArrowInstanceRenderer::TrackProjectile(AProjectile* Projectile)
+{
+	if (Projectile == NULL || TrackedProjectiles.Contains(Projectile))
+	{
+		return;
+	}
+
+	UStaticMeshComponent* ProjectileMesh = Projectile->GetProjectileMesh();
+	const int32 InstanceId = AddInstance(ProjectileMesh->GetStaticMesh(), ProjectileMesh->GetComponentTransform(), Projectile->IsDormant());
+	if (InstanceId != INDEX_NONE)
+	{
+		ProjectileMesh->SetVisibility(false);
+		TrackedProjectiles.Add(Projectile, InstanceId);
+	}
+}
+
+void AArrowInstanceRenderer::UntrackProjectile(AProjectile* Projectile)
+{
+	int32 InstanceId = INDEX_NONE;
+	if (TrackedProjectiles.RemoveAndCopyValue(Projectile, InstanceId))
+	{
+		RemoveInstance(InstanceId);
+		Projectile->GetProjectileMesh()->SetVisibility(true);
+	}
+}
+
+int32 AArrowInstanceRenderer::GetNumStaticInstances() const
+{
+	int32 NumStatic = 0;
+	for (const FInstanceBatch& Batch : Batches)
+	{
+		if (Batch.bStatic)
+		{
+			NumStatic += Batch.Transforms.Num();
+		}
+	}
+	return NumStatic;
+}
+
+void AArrowInstanceRenderer::LogInstanceCounts() const
+{
+	UE_LOG(LogArcher, Display, TEXT("%s: %d arrow instances (%d static) in %d batches"), *GetName(), GetNumInstances(), GetNumStaticInstances(), Batches.Num());
+	for (const FInstanceBatch& Batch : Batches)
+	{
+		UE_LOG(LogArcher, Display, TEXT("  %s %s: %d"), *GetNameSafe(Batch.Mesh), Batch.bStatic ? TEXT("static") : TEXT("moving"), Batch.Transforms.Num());
+	}
+}
+
+void AArrowInstanceRenderer::Tick(float DeltaSeconds)
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowInstanceCommit);
+
+	Super::Tick(DeltaSeconds);
+
+	// Follow tracked arrow actors, arrows that came to rest move over to a static batch once
+	for (auto It = TrackedProjectiles.CreateIterator(); It; ++It)
+	{
+		AProjectile* Projectile = It.Key().Get();
+		if (Projectile == NULL)
+		{
+			RemoveInstance(It.Value());
+			It.RemoveCurrent();
+			continue;
+		}
+
+		UStaticMeshComponent* ProjectileMesh = Projectile->GetProjectileMesh();
+		const bool bIsStatic = Batches[Instances[It.Value()].BatchIndex].bStatic;
+		if (Projectile->IsDormant() && !bIsStatic)
+		{
+			RemoveInstance(It.Value());
+			It.Value() = AddInstance(ProjectileMesh->GetStaticMesh(), ProjectileMesh->GetComponentTransform(), true);
+		}
+		else if (!bIsStatic)
+		{
+			UpdateInstance(It.Value(), ProjectileMesh->GetComponentTransform());
+		}
+	}
+
+	SIZE_T InstanceMemory = Instances.GetAllocatedSize() + TrackedProjectiles.GetAllocatedSize() + CommitTransforms.GetAllocatedSize();
+	for (FInstanceBatch& Batch : Batches)
+	{
+		CommitBatch(Batch);
+		InstanceMemory += Batch.Transforms.GetAllocatedSize() + Batch.InstanceIds.GetAllocatedSize() + Batch.DirtySlots.GetAllocatedSize();
+	}
+
+	SET_DWORD_STAT(STAT_ArrowInstances, Instances.Num());
+	SET_MEMORY_STAT(STAT_ArrowInstanceMemory, InstanceMemory);
+}
+
+int32 AArrowInstanceRenderer::FindOrAddBatch(UStaticMesh* Mesh, bool bStatic)
+{
+	for (int32 BatchIndex = 0; BatchIndex < Batches.Num(); ++BatchIndex)
+	{
+		if (Batches[BatchIndex].Mesh == Mesh && Batches[BatchIndex].bStatic == bStatic)
+		{
+			return BatchIndex;
+		}
+	}
+
+	// Moving instances would dirty a hierarchical component's cluster tree every frame
+	UInstancedStaticMeshComponent* Component = bStatic
+		? NewObject<UHierarchicalInstancedStaticMeshComponent>(this)
+		: NewObject<UInstancedStaticMeshComponent>(this);
+	Component->SetStaticMesh(Mesh);
+	Component->SetMobility(EComponentMobility::Movable);
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Component->SetCanEverAffectNavigation(false);
+	Component->SetupAttachment(RootComponent);
+	Component->RegisterComponent();
+	BatchComponents.Add(Component);
+
+	FInstanceBatch Batch;
+	Batch.Mesh = Mesh;
+	Batch.bStatic = bStatic;
+	Batch.Component = Component;
+	return Batches.Add(Batch);
+}
+
+void AArrowInstanceRenderer::MarkDirty(FInstanceBatch& Batch, int32 DenseIndex)
+{
+	while (Batch.DirtySlots.Num() <= DenseIndex)
+	{
+		Batch.DirtySlots.Add(false);
+	}
+	Batch.DirtySlots[DenseIndex] = true;
+}
+
+void AArrowInstanceRenderer::CommitBatch(FInstanceBatch& Batch)
+{
+	if (Batch.DirtySlots.Num() == 0)
+	{
+		return;
+	}
+
+	UInstancedStaticMeshComponent* Component = Batch.Component;
+	const int32 NumInstances = Batch.Transforms.Num();
+
+	// Component instances are only ever added or removed at the end, so dense index N is component instance N
+	const int32 NumUpdatable = FMath::Min(NumInstances, Component->GetInstanceCount());
+	for (TConstSetBitIterator<> It(Batch.DirtySlots); It && It.GetIndex() < NumUpdatable;)
+	{
+		const int32 RunStart = It.GetIndex();
+		int32 RunEnd = RunStart + 1;
+		for (++It; It && It.GetIndex() == RunEnd && RunEnd < NumUpdatable; ++It)
+		{
+			++RunEnd;
+		}
+
+		// Arrows in flight usually change all at once, the whole batch goes over without a copy
+		if (RunStart == 0 && RunEnd == NumInstances)
+		{
+			Component->BatchUpdateInstancesTransforms(0, Batch.Transforms, true, false, true);
+			continue;
+		}
+
+		CommitTransforms.Reset();
+		CommitTransforms.Append(&Batch.Transforms[RunStart], RunEnd - RunStart);
+		Component->BatchUpdateInstancesTransforms(RunStart, CommitTransforms, true, false, true);
+	}
+
+	for (int32 Index = Component->GetInstanceCount(); Index < NumInstances; ++Index)
+	{
+		Component->AddInstanceWorldSpace(Batch.Transforms[Index]);
+	}
+
+	for (int32 Index = Component->GetInstanceCount() - 1; Index >= NumInstances; --Index)
+	{
+		Component->RemoveInstance(Index);
+	}
+
+	Component->MarkRenderStateDirty();
+	Batch.DirtySlots.Empty(NumInstances);
+}
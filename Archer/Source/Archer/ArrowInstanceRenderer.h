@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ArrowInstanceRenderer.generated.h"
+
+class AProjectile;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * Draws arrows as instances of shared instanced meshes, one per arrow mesh and mobility,
+ * so hundreds of arrows cost a handful of primitives instead of one scene proxy each.
+ * Arrows in flight use a plain instanced mesh, a hierarchical one would rebuild its cluster tree every frame they move.
+ * Arrows at rest use a hierarchical instanced mesh, culled and LODed per cluster.
+ * Transforms are gathered on the CPU and pushed to the components in bulk once per frame.
+ */
+UCLASS(NotPlaceable)
+class ARCHER_API AArrowInstanceRenderer : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AArrowInstanceRenderer();
+
+	/** Returns instance renderer of the world, spawning it on first use */
+	static AArrowInstanceRenderer* Get(const UObject* WorldContextObject);
+
+	/**
+	 * Add arrow instance
+	 * @param Mesh - mesh to draw
+	 * @param Transform - world transform of the mesh
+	 * @param bStatic - true for arrows that won't move anymore, they are kept apart from arrows updated every frame
+	 * @return id used to update or remove the instance
+	 */
+	int32 AddInstance(UStaticMesh* Mesh, const FTransform& Transform, bool bStatic);
+
+	/** Move instance, committed to the component at the end of the frame */
+	void UpdateInstance(int32 InstanceId, const FTransform& Transform);
+
+	void RemoveInstance(int32 InstanceId);
+
+	/** Draw arrow actor through an instance that follows it, its own mesh component is hidden */
+	void TrackProjectile(AProjectile* Projectile);
+
+	/** Stop drawing arrow actor, its mesh component becomes visible again */
+	void UntrackProjectile(AProjectile* Projectile);
+
+	/** Returns number of arrows drawn as instances */
+	UFUNCTION(BlueprintPure, Category = "Arrow Rendering")
+	int32 GetNumInstances() const { return Instances.Num(); }
+
+	/** Returns number of instances of arrows that came to rest */
+	UFUNCTION(BlueprintPure, Category = "Arrow Rendering")
+	int32 GetNumStaticInstances() const;
+
+	/** Write instance counts of every batch to the log, works in -nullrhi runs too */
+	void LogInstanceCounts() const;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	/** Instances of one mesh and mobility. Transforms are dense, removal moves the last instance into the hole */
+	struct FInstanceBatch
+	{
+		UStaticMesh* Mesh;
+		bool bStatic;
+		/** Hierarchical for static batches */
+		UInstancedStaticMeshComponent* Component;
+		TArray<FTransform> Transforms;
+		TArray<int32> InstanceIds;
+		/** Dense indices that differ from what the component holds, empty when in sync */
+		TBitArray<> DirtySlots;
+	};
+
+	struct FInstanceRecord
+	{
+		int32 BatchIndex;
+		int32 DenseIndex;
+	};
+
+	int32 FindOrAddBatch(UStaticMesh* Mesh, bool bStatic);
+
+	void MarkDirty(FInstanceBatch& Batch, int32 DenseIndex);
+
+	/** Push changed transforms of Batch into its component, one call per run of adjacent dirty slots */
+	void CommitBatch(FInstanceBatch& Batch);
+
+	TArray<FInstanceBatch> Batches;
+
+	/** Transforms of one run of dirty slots, kept to reuse its allocation */
+	TArray<FTransform> CommitTransforms;
+
+	TSparseArray<FInstanceRecord> Instances;
+
+	/** Arrow actors drawn by this renderer and their instance ids */
+	TMap<TWeakObjectPtr<AProjectile>, int32> TrackedProjectiles;
+
+	/** Keeps batch components referenced */
+	UPROPERTY(Transient)
+	TArray<UInstancedStaticMeshComponent*> BatchComponents;
+};
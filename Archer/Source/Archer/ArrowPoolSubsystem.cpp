@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArrowPoolSubsystem.h"
+#include "Archer.h"
+#include "Projectile.h"
+#include "GameFramework/Pawn.h"
+
+UArrowPoolSubsystem::UArrowPoolSubsystem()
+{
+	PrewarmCount = 16;
+}
+
+void UArrowPoolSubsystem::Prewarm(TSubclassOf<AProjectile> ProjectileClass)
+{
+	if (ProjectileClass == NULL)
+	{
+		return;
+	}
+
+	FArrowPoolBucket& Bucket = Buckets.FindOrAdd(ProjectileClass);
+	while (Bucket.Available.Num() < PrewarmCount)
+	{
+		AProjectile* Projectile = SpawnPooledProjectile(ProjectileClass);
+		if (Projectile == NULL)
+		{
+			break;
+		}
+		Bucket.Available.Add(Projectile);
+		INC_DWORD_STAT(STAT_PooledArrows);
+	}
+}
+
+AProjectile* UArrowPoolSubsystem::Acquire(TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Owner)
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowPoolAcquire);
+
+	if (ProjectileClass == NULL)
+	{
+		return nullptr;
+	}
+
+	AProjectile* Projectile = nullptr;
+
+	FArrowPoolBucket& Bucket = Buckets.FindOrAdd(ProjectileClass);
+	while (Projectile == NULL && Bucket.Available.Num() > 0)
+	{
+		// Arrows may have been destroyed behind our back (e.g. level streamed out)
+		AProjectile* Candidate = Bucket.Available.Pop(false);
+		DEC_DWORD_STAT(STAT_PooledArrows);
+		if (Candidate != NULL && !Candidate->IsPendingKill())
+		{
+			Projectile = Candidate;
+		}
+	}
+
+	if (Projectile != NULL)
+	{
+		++Stats.Hits;
+	}
+	else
+	{
+		++Stats.Misses;
+		Projectile = SpawnPooledProjectile(ProjectileClass);
+		if (Projectile == NULL)
+		{
+			return nullptr;
+		}
+	}
+
+	++Stats.InUse;
+	Stats.HighWaterMark = FMath::Max(Stats.HighWaterMark, Stats.InUse);
+
+	Projectile->SetOwner(Owner);
+	Projectile->Instigator = Cast<APawn>(Owner);
+	Projectile->OnAcquiredFromPool(Location, Rotation);
+
+	return Projectile;
+}
+
+void UArrowPoolSubsystem::Release(AProjectile* Projectile)
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowPoolRelease);
+
+	if (Projectile == NULL || Projectile->IsPendingKill() || Projectile->IsInPool())
+	{
+		return;
+	}
+
+	Projectile->OnReturnedToPool();
+	Projectile->SetOwner(nullptr);
+	Projectile->Instigator = nullptr;
+
+	Stats.InUse = FMath::Max(Stats.InUse - 1, 0);
+	Buckets.FindOrAdd(Projectile->GetClass()).Available.Add(Projectile);
+	INC_DWORD_STAT(STAT_PooledArrows);
+}
+
+void UArrowPoolSubsystem::ResetWorldState()
+{
+	// Pooled actors belong to the world that is going away, it will destroy them
+	Buckets.Empty();
+	Stats = FArrowPoolStats();
+	SET_DWORD_STAT(STAT_PooledArrows, 0);
+}
+
+AProjectile* UArrowPoolSubsystem::SpawnPooledProjectile(UClass* ProjectileClass)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return nullptr;
+	}
+
+	// Deferred so BeginPlay() already sees the pool and leaves lifetime and rendering to OnAcquiredFromPool()
+	AProjectile* Projectile = World->SpawnActorDeferred<AProjectile>(ProjectileClass, FTransform::Identity, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Projectile == NULL)
+	{
+		UE_LOG(LogArcher, Warning, TEXT("Arrow pool failed to spawn %s"), *GetNameSafe(ProjectileClass));
+		return nullptr;
+	}
+	Projectile->SetOwningPool(this);
+	Projectile->FinishSpawning(FTransform::Identity);
+
+	// Pooled arrows live as long as the world, the pool decides when they are out of play
+	Projectile->SetLifeSpan(0.0f);
+	Projectile->OnReturnedToPool();
+
+	return Projectile;
+}
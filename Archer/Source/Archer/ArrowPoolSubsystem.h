@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ArcherWorldSubsystem.h"
+#include "ArrowPoolSubsystem.generated.h"
+
+class AProjectile;
+
+/** Counters describing how well the arrow pool serves Shoot() requests */
+USTRUCT(BlueprintType)
+struct FArrowPoolStats
+{
+	GENERATED_BODY()
+
+	/** Requests served by an arrow that was already waiting in the pool */
+	UPROPERTY(BlueprintReadOnly, Category = "Arrow Pool")
+	int32 Hits = 0;
+
+	/** Requests that had to spawn a new arrow because the pool was empty */
+	UPROPERTY(BlueprintReadOnly, Category = "Arrow Pool")
+	int32 Misses = 0;
+
+	/** Arrows currently handed out */
+	UPROPERTY(BlueprintReadOnly, Category = "Arrow Pool")
+	int32 InUse = 0;
+
+	/** Largest number of arrows handed out at the same time */
+	UPROPERTY(BlueprintReadOnly, Category = "Arrow Pool")
+	int32 HighWaterMark = 0;
+};
+
+/** Free arrows of a single projectile class */
+USTRUCT()
+struct FArrowPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AProjectile*> Available;
+};
+
+/**
+ * Keeps inactive AProjectile actors alive and hands them out instead of spawning a new actor for every shot.
+ * Arrows come back on hit or when UProjectileLifetimeSubsystem expires them, so arena fights don't pay SpawnActor/Destroy and GC cost per shot.
+ */
+UCLASS(config = Game)
+class ARCHER_API UArrowPoolSubsystem : public UArcherWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UArrowPoolSubsystem();
+
+	/** Number of arrows spawned up front for each projectile class */
+	UPROPERTY(config, EditAnywhere, Category = "Arrow Pool")
+	int32 PrewarmCount;
+
+	/** Make sure at least PrewarmCount arrows of ProjectileClass are waiting in the pool */
+	void Prewarm(TSubclassOf<AProjectile> ProjectileClass);
+
+	/**
+	 * Take an arrow out of the pool (spawning one if the pool is empty) and launch it.
+	 * @param ProjectileClass - class of arrow to launch
+	 * @param Location - world location the arrow starts from
+	 * @param Rotation - direction of flight
+	 * @param Owner - actor that fired the arrow
+	 * @return launched arrow, nullptr if it could not be spawned
+	 */
+	AProjectile* Acquire(TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Owner);
+
+	/** Put arrow back into the pool, it is hidden and stops simulating */
+	void Release(AProjectile* Projectile);
+
+	/** Returns pool hits, misses and high-water mark */
+	UFUNCTION(BlueprintPure, Category = "Arrow Pool")
+	const FArrowPoolStats& GetStats() const { return Stats; }
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	AProjectile* SpawnPooledProjectile(UClass* ProjectileClass);
+
+	UPROPERTY()
+	TMap<UClass*, FArrowPoolBucket> Buckets;
+
+	FArrowPoolStats Stats;
+};
@@ -0,0 +1,412 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ArrowSimulationManager.h"
+#include "Archer.h"
+#include "Projectile.h"
+#include "ArcherCharacter.h"
+#include "ArcherImpactEventSubsystem.h"
+#include "ArcherLagCompensationComponent.h"
+#include "ArrowImpulseSubsystem.h"
+#include "ArrowPoolSubsystem.h"
+#include "ArrowInstanceRenderer.h"
+#include "StuckArrowSubsystem.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+
+AArrowSimulationManager::AArrowSimulationManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Arrows have to be moved before physics so impacts and impulses land in this frame's simulation
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	MaxFlightTime = 10.0f;
+	bUseAsyncTraces = true;
+	InstanceRenderer = nullptr;
+	AsyncTraceTime = 0.0f;
+}
+
+AArrowSimulationManager* AArrowSimulationManager::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	if (World == NULL)
+	{
+		return nullptr;
+	}
+
+	for (TActorIterator<AArrowSimulationManager> It(World); It; ++It)
+	{
+		if (!It->IsPendingKill())
+		{
+			return *It;
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<AArrowSimulationManager>(SpawnParams);
+}
+
+void AArrowSimulationManager::LaunchArrow(TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Instigator, float SpeedScale, float TimeAhead, bool bCosmetic, float ShotLatency)
+{
+	const AProjectile* ProjectileDefaults = ProjectileClass != NULL ? ProjectileClass->GetDefaultObject<AProjectile>() : nullptr;
+	if (ProjectileDefaults == NULL)
+	{
+		return;
+	}
+
+	const UProjectileMovementComponent* MovementDefaults = ProjectileDefaults->GetProjectileMovement();
+
+	Positions.Add(Location);
+	PreviousPositions.Add(Location);
+	Velocities.Add(Rotation.Vector() * MovementDefaults->InitialSpeed * SpeedScale);
+	GravityZ.Add(GetWorld()->GetGravityZ() * MovementDefaults->ProjectileGravityScale);
+	DragCoefficients.Add(ProjectileDefaults->DragCoefficient);
+	RemainingFlightTimes.Add(MaxFlightTime);
+	Instigators.Add(Instigator);
+	ProjectileClasses.Add(ProjectileClass);
+	PendingTraces.Add(FTraceHandle());
+	CosmeticFlags.Add(bCosmetic);
+	// Only the server rewinds, and only for shots of other machines
+	ShotLatencies.Add(!bCosmetic && GetNetMode() != NM_Client ? ShotLatency : 0.0f);
+
+	ReferencedClasses.Add(ProjectileClass);
+
+	// Dedicated server draws nothing
+	if (InstanceRenderer == NULL && GetNetMode() != NM_DedicatedServer)
+	{
+		InstanceRenderer = AArrowInstanceRenderer::Get(this);
+	}
+
+	const int32 NewIndex = Positions.Num() - 1;
+	RenderInstanceIds.Add(InstanceRenderer != NULL ? InstanceRenderer->AddInstance(ProjectileDefaults->GetProjectileMesh()->GetStaticMesh(), GetMeshTransform(NewIndex), false) : INDEX_NONE);
+
+	// Released earlier in the frame, one step of its own catches the arrow up before the next Integrate()
+	if (TimeAhead > 0.0f)
+	{
+		FVector& Velocity = Velocities[NewIndex];
+		const FVector DragAcceleration = Velocity * (-DragCoefficients[NewIndex] * Velocity.Size());
+		Velocity += (DragAcceleration + FVector(0.0f, 0.0f, GravityZ[NewIndex])) * TimeAhead;
+		Positions[NewIndex] += Velocity * TimeAhead;
+		PreviousPositions[NewIndex] = Positions[NewIndex];
+		RemainingFlightTimes[NewIndex] -= TimeAhead;
+
+		FHitResult Hit;
+		if (TraceSegment(NewIndex, Location, Positions[NewIndex], GetWorld()->GetTimeSeconds(), Hit))
+		{
+			ResolveImpact(NewIndex, Hit);
+			RemoveArrow(NewIndex);
+			return;
+		}
+
+		if (InstanceRenderer != NULL)
+		{
+			InstanceRenderer->UpdateInstance(RenderInstanceIds[NewIndex], GetMeshTransform(NewIndex));
+		}
+	}
+}
+
+void AArrowSimulationManager::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (Positions.Num() > 0)
+	{
+		if (bUseAsyncTraces)
+		{
+			// Last frame's segments first, arrows that hit must not fly on
+			ResolveAsyncTraces();
+			Integrate(DeltaSeconds);
+			RequestAsyncTraces();
+		}
+		else
+		{
+			Integrate(DeltaSeconds);
+			TraceAndResolveImpacts();
+		}
+		UpdateInstances();
+	}
+
+	SET_DWORD_STAT(STAT_SimulatedArrows, Positions.Num());
+	SET_MEMORY_STAT(STAT_ArrowSimulationMemory, Positions.GetAllocatedSize() + PreviousPositions.GetAllocatedSize() + Velocities.GetAllocatedSize()
+		+ GravityZ.GetAllocatedSize() + DragCoefficients.GetAllocatedSize() + RemainingFlightTimes.GetAllocatedSize() + Instigators.GetAllocatedSize()
+		+ ProjectileClasses.GetAllocatedSize() + RenderInstanceIds.GetAllocatedSize() + PendingTraces.GetAllocatedSize() + CosmeticFlags.GetAllocatedSize()
+		+ ShotLatencies.GetAllocatedSize());
+}
+
+void AArrowSimulationManager::Integrate(float DeltaSeconds)
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowSimulationIntegrate);
+
+	const int32 NumArrows = Positions.Num();
+
+	FVector* RESTRICT Position = Positions.GetData();
+	FVector* RESTRICT PreviousPosition = PreviousPositions.GetData();
+	FVector* RESTRICT Velocity = Velocities.GetData();
+	const float* RESTRICT Gravity = GravityZ.GetData();
+	const float* RESTRICT Drag = DragCoefficients.GetData();
+	float* RESTRICT FlightTime = RemainingFlightTimes.GetData();
+
+	// Semi-implicit Euler: quadratic drag against the direction of flight, then gravity, then position
+	for (int32 Index = 0; Index < NumArrows; ++Index)
+	{
+		const FVector DragAcceleration = Velocity[Index] * (-Drag[Index] * Velocity[Index].Size());
+		Velocity[Index] += (DragAcceleration + FVector(0.0f, 0.0f, Gravity[Index])) * DeltaSeconds;
+	}
+
+	for (int32 Index = 0; Index < NumArrows; ++Index)
+	{
+		PreviousPosition[Index] = Position[Index];
+		Position[Index] += Velocity[Index] * DeltaSeconds;
+	}
+
+	for (int32 Index = 0; Index < NumArrows; ++Index)
+	{
+		FlightTime[Index] -= DeltaSeconds;
+	}
+}
+
+void AArrowSimulationManager::TraceAndResolveImpacts()
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowSimulationTraces);
+
+	const float Time = GetWorld()->GetTimeSeconds();
+
+	// Walk backwards so swap-removal doesn't skip arrows
+	for (int32 Index = Positions.Num() - 1; Index >= 0; --Index)
+	{
+		FHitResult Hit;
+		if (TraceSegment(Index, PreviousPositions[Index], Positions[Index], Time, Hit))
+		{
+			ResolveImpact(Index, Hit);
+			RemoveArrow(Index);
+			continue;
+		}
+
+		if (RemainingFlightTimes[Index] <= 0.0f)
+		{
+			RemoveArrow(Index);
+		}
+	}
+}
+
+void AArrowSimulationManager::RequestAsyncTraces()
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowSimulationTraces);
+
+	UWorld* const World = GetWorld();
+	AsyncTraceTime = World->GetTimeSeconds();
+
+	for (int32 Index = 0; Index < Positions.Num(); ++Index)
+	{
+		ECollisionChannel TraceChannel;
+		FCollisionResponseParams ResponseParams;
+		GetTraceResponse(Index, TraceChannel, ResponseParams);
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ArrowSimulationAsync), false, Instigators[Index].Get());
+		PendingTraces[Index] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, PreviousPositions[Index], Positions[Index], TraceChannel, QueryParams, ResponseParams);
+	}
+}
+
+void AArrowSimulationManager::ResolveAsyncTraces()
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowSimulationTraces);
+
+	UWorld* const World = GetWorld();
+
+	for (int32 Index = Positions.Num() - 1; Index >= 0; --Index)
+	{
+		if (!PendingTraces[Index].IsValid())
+		{
+			continue;
+		}
+
+		FHitResult Hit;
+		bool bHit = false;
+
+		FTraceDatum TraceData;
+		if (World->QueryTraceData(PendingTraces[Index], TraceData))
+		{
+			for (const FHitResult& Result : TraceData.OutHits)
+			{
+				if (Result.bBlockingHit)
+				{
+					Hit = Result;
+					bHit = true;
+					break;
+				}
+			}
+
+			// Rewound archers are not in the physics scene, sweep them up to where the trace stopped
+			bHit = SweepRewoundArchers(Index, PreviousPositions[Index], bHit ? Hit.Location : Positions[Index], AsyncTraceTime, Hit) || bHit;
+		}
+		else
+		{
+			// Result got lost (e.g. world was paused in between), trace the segment now rather than let the arrow pass through
+			bHit = TraceSegment(Index, PreviousPositions[Index], Positions[Index], AsyncTraceTime, Hit);
+		}
+		PendingTraces[Index] = FTraceHandle();
+
+		if (bHit)
+		{
+			ResolveImpact(Index, Hit);
+			RemoveArrow(Index);
+		}
+	}
+
+	RemoveExpiredArrows();
+}
+
+void AArrowSimulationManager::RemoveExpiredArrows()
+{
+	for (int32 Index = Positions.Num() - 1; Index >= 0; --Index)
+	{
+		if (RemainingFlightTimes[Index] <= 0.0f)
+		{
+			RemoveArrow(Index);
+		}
+	}
+}
+
+void AArrowSimulationManager::ResolveImpact(int32 Index, const FHitResult& Hit)
+{
+	UPrimitiveComponent* OtherComp = Hit.GetComponent();
+	const AProjectile* ProjectileDefaults = ProjectileClasses[Index]->GetDefaultObject<AProjectile>();
+
+	// Cosmetic copies only show where the shot lands, damage and impulses come from where it is authoritative
+	const bool bCosmetic = CosmeticFlags[Index];
+
+	AArcherCharacter* Victim = Cast<AArcherCharacter>(Hit.GetActor());
+	if (Victim != NULL && !bCosmetic)
+	{
+		if (UArcherImpactEventSubsystem* ImpactEvents = UArcherWorldSubsystem::Get<UArcherImpactEventSubsystem>(this))
+		{
+			ImpactEvents->QueueImpact(Victim, Instigators[Index].Get(), ProjectileDefaults->GetImpactDamage(Velocities[Index]), Velocities[Index], Hit);
+		}
+	}
+
+	// Physics bodies get pushed and the arrow is gone, same as AProjectile::OnHit
+	if (OtherComp != NULL && OtherComp->IsSimulatingPhysics())
+	{
+		if (bCosmetic)
+		{
+			return;
+		}
+
+		if (UArrowImpulseSubsystem* ImpulseSubsystem = UArcherWorldSubsystem::Get<UArrowImpulseSubsystem>(this))
+		{
+			ImpulseSubsystem->QueueImpulse(OtherComp, Hit.BoneName, Velocities[Index] * ProjectileDefaults->ImpactImpulseScale, Hit.ImpactPoint);
+		}
+		else
+		{
+			OtherComp->AddImpulseAtLocation(Velocities[Index] * ProjectileDefaults->ImpactImpulseScale, Hit.ImpactPoint);
+		}
+		return;
+	}
+
+	// Sticking arrows never need an actor, the proxy is made straight from the class defaults
+	if (ProjectileDefaults->ImpactMode == EArrowImpactMode::Stick)
+	{
+		if (UStuckArrowSubsystem* StuckArrows = UArcherWorldSubsystem::Get<UStuckArrowSubsystem>(this))
+		{
+			const UStaticMeshComponent* MeshDefaults = ProjectileDefaults->GetProjectileMesh();
+			StuckArrows->StickArrow(MeshDefaults->GetStaticMesh(), MeshDefaults->GetRelativeTransform() * FTransform(Velocities[Index].Rotation(), Hit.Location), Hit);
+		}
+		return;
+	}
+
+	// Anything else keeps the arrow, only now it needs an actor to stay visible
+	UArrowPoolSubsystem* ArrowPool = UArcherWorldSubsystem::Get<UArrowPoolSubsystem>(this);
+	if (ArrowPool != NULL)
+	{
+		AProjectile* Projectile = ArrowPool->Acquire(ProjectileClasses[Index], Hit.Location, Velocities[Index].Rotation(), Instigators[Index].Get());
+		if (Projectile != NULL)
+		{
+			Projectile->StopAtImpact(Hit);
+		}
+	}
+}
+
+void AArrowSimulationManager::GetTraceResponse(int32 Index, ECollisionChannel& OutChannel, FCollisionResponseParams& OutResponseParams) const
+{
+	// Trace with what an arrow actor of the class collides as and with
+	const UPrimitiveComponent* CollisionDefaults = ProjectileClasses[Index]->GetDefaultObject<AProjectile>()->GetCollisionComp();
+	OutChannel = CollisionDefaults->GetCollisionObjectType();
+	OutResponseParams = FCollisionResponseParams(CollisionDefaults->GetCollisionResponseToChannels());
+
+	if (ShotLatencies[Index] > 0.0f)
+	{
+		OutResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);
+	}
+}
+
+bool AArrowSimulationManager::TraceSegment(int32 Index, const FVector& Start, const FVector& End, float Time, FHitResult& OutHit) const
+{
+	ECollisionChannel TraceChannel;
+	FCollisionResponseParams ResponseParams;
+	GetTraceResponse(Index, TraceChannel, ResponseParams);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ArrowSimulation), false, Instigators[Index].Get());
+	const bool bHit = GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, TraceChannel, QueryParams, ResponseParams);
+	return SweepRewoundArchers(Index, Start, bHit ? OutHit.Location : End, Time, OutHit) || bHit;
+}
+
+bool AArrowSimulationManager::SweepRewoundArchers(int32 Index, const FVector& Start, const FVector& End, float Time, FHitResult& OutHit) const
+{
+	if (ShotLatencies[Index] <= 0.0f)
+	{
+		return false;
+	}
+
+	// Same hitboxes and search radius as an actor arrow of the class, see AProjectile::SweepRewoundArchers()
+	const AProjectile* ProjectileDefaults = ProjectileClasses[Index]->GetDefaultObject<AProjectile>();
+	return UArcherLagCompensationComponent::SweepRewoundArchers(this, Time - ShotLatencies[Index], Start, End,
+		ProjectileDefaults->GetCollisionComp()->GetScaledSphereRadius(), ProjectileDefaults->RewindQueryRadius, Instigators[Index].Get(), OutHit);
+}
+
+void AArrowSimulationManager::RemoveArrow(int32 Index)
+{
+	if (InstanceRenderer != NULL)
+	{
+		InstanceRenderer->RemoveInstance(RenderInstanceIds[Index]);
+	}
+
+	Positions.RemoveAtSwap(Index, 1, false);
+	PreviousPositions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	GravityZ.RemoveAtSwap(Index, 1, false);
+	DragCoefficients.RemoveAtSwap(Index, 1, false);
+	RemainingFlightTimes.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+	ProjectileClasses.RemoveAtSwap(Index, 1, false);
+	RenderInstanceIds.RemoveAtSwap(Index, 1, false);
+	PendingTraces.RemoveAtSwap(Index, 1, false);
+	CosmeticFlags.RemoveAtSwap(Index, 1, false);
+	ShotLatencies.RemoveAtSwap(Index, 1, false);
+}
+
+void AArrowSimulationManager::UpdateInstances()
+{
+	if (InstanceRenderer == NULL)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < Positions.Num(); ++Index)
+	{
+		InstanceRenderer->UpdateInstance(RenderInstanceIds[Index], GetMeshTransform(Index));
+	}
+}
+
+FTransform AArrowSimulationManager::GetMeshTransform(int32 Index) const
+{
+	// Mesh offset set up in the projectile blueprint is kept relative to the arrow
+	const FTransform& MeshOffset = ProjectileClasses[Index]->GetDefaultObject<AProjectile>()->GetProjectileMesh()->GetRelativeTransform();
+	return MeshOffset * FTransform(Velocities[Index].Rotation(), Positions[Index]);
+}
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "WorldCollision.h"
+#include "ArrowSimulationManager.generated.h"
+
+class AProjectile;
+
+/**
+ * Simulates all in-flight arrows of a world in one place instead of one UProjectileMovementComponent per arrow.
+ * Arrow state is kept as structure of arrays, integrated in tight loops and traced in one batch.
+ * Arrows in flight are drawn through AArrowInstanceRenderer.
+ * An AProjectile actor is only taken from the pool when an arrow embeds itself in something.
+ */
+UCLASS(config = Game, NotPlaceable)
+class ARCHER_API AArrowSimulationManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AArrowSimulationManager();
+
+	/** Seconds an arrow may fly without hitting anything before it is dropped */
+	UPROPERTY(config, EditAnywhere, Category = "Arrow Simulation")
+	float MaxFlightTime;
+
+	/**
+	 * Trace arrow segments asynchronously and consume the results next frame instead of blocking the game thread.
+	 * Impacts are resolved from the trace hit itself, so results match synchronous tracing, only a frame later.
+	 * On by default, turning it off traces every arrow one after another on the game thread and is meant for debugging.
+	 */
+	UPROPERTY(config, EditAnywhere, Category = "Arrow Simulation")
+	bool bUseAsyncTraces;
+
+	/** Returns simulation manager of the world, spawning it on first use */
+	static AArrowSimulationManager* Get(const UObject* WorldContextObject);
+
+	/**
+	 * Start simulating a new arrow
+	 * @param ProjectileClass - class whose defaults (speed, drag, mesh) describe the arrow
+	 * @param Location - world location the arrow starts from
+	 * @param Rotation - direction of flight
+	 * @param Instigator - actor that fired the arrow, ignored by traces
+	 * @param SpeedScale - fraction of the class launch speed
+	 * @param TimeAhead - seconds the arrow has already been flying, it is moved on and traced by that much right away
+	 * @param bCosmetic - arrow only stands in for a shot simulated elsewhere, it deals no damage and pushes nothing
+	 * @param ShotLatency - seconds the shooter's view lagged behind the server, archers are then hit where they were that long ago
+	 */
+	void LaunchArrow(TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FRotator& Rotation, AActor* Instigator, float SpeedScale = 1.0f, float TimeAhead = 0.0f, bool bCosmetic = false, float ShotLatency = 0.0f);
+
+	/** Returns number of arrows currently in flight */
+	int32 GetNumArrows() const { return Positions.Num(); }
+
+	virtual void Tick(float DeltaSeconds) override;
+
+private:
+	/** Advance velocities and positions of all arrows by DeltaSeconds */
+	void Integrate(float DeltaSeconds);
+
+	/** Trace every arrow from its previous to its new position and resolve impacts */
+	void TraceAndResolveImpacts();
+
+	/** Queue async trace of every arrow segment, results are read by ResolveAsyncTraces() next frame */
+	void RequestAsyncTraces();
+
+	/** Resolve impacts found by the traces requested last frame */
+	void ResolveAsyncTraces();
+
+	/** Remove arrows that flew longer than MaxFlightTime */
+	void RemoveExpiredArrows();
+
+	/** Apply hit of arrow at Index, the arrow stops there whatever it hit */
+	void ResolveImpact(int32 Index, const FHitResult& Hit);
+
+	/** Trace channel and responses of arrow at Index, lag compensated arrows leave present archers to SweepRewoundArchers() */
+	void GetTraceResponse(int32 Index, ECollisionChannel& OutChannel, FCollisionResponseParams& OutResponseParams) const;
+
+	/** Trace arrow at Index from Start to End flown at world Time, returns true if it hit the world or a rewound archer */
+	bool TraceSegment(int32 Index, const FVector& Start, const FVector& End, float Time, FHitResult& OutHit) const;
+
+	/** Hit rewound archers on the way from Start to End for a lag compensated arrow, OutHit is only written on a hit */
+	bool SweepRewoundArchers(int32 Index, const FVector& Start, const FVector& End, float Time, FHitResult& OutHit) const;
+
+	void RemoveArrow(int32 Index);
+
+	/** Hand in-flight arrow transforms to the instance renderer */
+	void UpdateInstances();
+
+	/** Returns world transform of mesh of arrow at Index */
+	FTransform GetMeshTransform(int32 Index) const;
+
+	// Structure of arrays, index N of every array describes the same arrow
+	TArray<FVector> Positions;
+	TArray<FVector> PreviousPositions;
+	TArray<FVector> Velocities;
+	TArray<float> GravityZ;
+	TArray<float> DragCoefficients;
+	TArray<float> RemainingFlightTimes;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+	TArray<UClass*> ProjectileClasses;
+	TArray<int32> RenderInstanceIds;
+	TArray<FTraceHandle> PendingTraces;
+	TArray<bool> CosmeticFlags;
+	TArray<float> ShotLatencies;
+
+	/** World time the pending async traces were flown at, lag compensated arrows rewind from it */
+	float AsyncTraceTime;
+
+	UPROPERTY(Transient)
+	class AArrowInstanceRenderer* InstanceRenderer;
+
+	/** Keeps arrow classes alive while arrows of that class fly */
+	UPROPERTY(Transient)
+	TSet<UClass*> ReferencedClasses;
+};
@@ -2,20 +2,39 @@
 
 
 #include "Projectile.h"
+#include "Archer.h"
 #include "Components/SphereComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
+#include "ArrowImpulseSubsystem.h"
+#include "ArrowPoolSubsystem.h"
+#include "ProjectileLifetimeSubsystem.h"
+#include "StuckArrowSubsystem.h"
+#include "ArrowInstanceRenderer.h"
+#include "ArcherCharacter.h"
+#include "ArcherImpactEventSubsystem.h"
+#include "ArcherLagCompensationComponent.h"
 
 // Sets default values
 AProjectile::AProjectile()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;	
+ 	// Projectile movement component ticks on its own while arrow flies, Tick() only runs for lag compensated arrows on the server
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
 
 	// Default value for offsetting location and rotation to be grabed and pointed in desired direction 
 	ProjectileAimGripPointOffset = FVector(0.f, 0.f, 0.f);
 	ProjectileAimPointRotationOffset = FRotator(0.f, 0.f, 0.f);
 
+	SimulationMode = EArrowSimulationMode::Actor;
+	ImpactMode = EArrowImpactMode::Stick;
+	DragCoefficient = 0.0f;
+	bUseInstancedRendering = false;
+	ImpactImpulseScale = 100.0f;
+	Damage = 40.0f;
+	RewindQueryRadius = 400.0f;
+
 	// Create sphere collision
 	CollisionComp = CreateDefaultSubobject<USphereComponent>(TEXT("SphereComp"));
 	CollisionComp->InitSphereRadius(2.0f);
@@ -40,19 +59,283 @@ AProjectile::AProjectile()
 	ProjectileMovement->MaxSpeed = 6000.f;
 	ProjectileMovement->bRotationFollowsVelocity = true;
 	ProjectileMovement->bShouldBounce = true;
+	ProjectileMovement->OnProjectileStop.AddDynamic(this, &AProjectile::OnProjectileStop);
 
-	// Die after 3 seconds by default
-	InitialLifeSpan = 300.0f;
-	
+	// Expiry is handled by UProjectileLifetimeSubsystem, this only covers worlds without a game instance
+	InitialLifeSpan = 30.0f;
+
+	bIsInPool = false;
+	bIsDormant = false;
+	bIsCosmetic = false;
+	ShotLatency = 0.0f;
+	LastSweepLocation = FVector::ZeroVector;
+	LifetimeSlot = INDEX_NONE;
+
+	// Shots are replicated as AArcherCharacter RPCs, every machine simulates its own arrows.
+	// Classes that need authoritative arrows on clients can turn this on, UArcherReplicationGraph routes them by trajectory
+	bReplicates = false;
+}
+
+void AProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Pooled arrows wait in the pool until OnAcquiredFromPool() puts them in play
+	if (OwningPool.IsValid())
+	{
+		return;
+	}
+
+	if (UProjectileLifetimeSubsystem* LifetimeManager = UArcherWorldSubsystem::Get<UProjectileLifetimeSubsystem>(this))
+	{
+		SetLifeSpan(0.0f);
+		LifetimeManager->RegisterProjectile(this);
+	}
+
+	UpdateInstancedRendering();
 }
 
 void AProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalIMpulse, const FHitResult& Hit)
 {
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ProjectileOnHit);
+
+	// Move ends here before Tick() gets to it, archers it passed through in the past come first
+	if (IsActorTickEnabled() && SweepRewoundArchers())
+	{
+		return;
+	}
+
+	// Lag compensated arrows hit archers only through SweepRewoundArchers(), this is the server's own shots
+	if (HasAuthority() && !bIsCosmetic && ShotLatency <= 0.0f)
+	{
+		AArcherCharacter* Victim = Cast<AArcherCharacter>(OtherActor);
+		UArcherImpactEventSubsystem* ImpactEvents = UArcherWorldSubsystem::Get<UArcherImpactEventSubsystem>(this);
+		if (Victim != NULL && ImpactEvents != NULL)
+		{
+			// Damage and reactions are resolved with the frame's other hits on the same archer
+			ImpactEvents->QueueImpact(Victim, GetOwner(), GetImpactDamage(GetVelocity()), GetVelocity(), Hit);
+		}
+	}
+
 	// Only add impulse and destroy projectile if we hit a physics
 	if ((OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL) && OtherComp->IsSimulatingPhysics())
 	{
-		OtherComp->AddImpulseAtLocation(GetVelocity() * 100.0f, GetActorLocation());
+		if (!bIsCosmetic)
+		{
+			// Pushed together with the other hits of this frame before the next physics step
+			if (UArrowImpulseSubsystem* ImpulseSubsystem = UArcherWorldSubsystem::Get<UArrowImpulseSubsystem>(this))
+			{
+				ImpulseSubsystem->QueueImpulse(OtherComp, Hit.BoneName, GetVelocity() * ImpactImpulseScale, GetActorLocation());
+			}
+			else
+			{
+				OtherComp->AddImpulseAtLocation(GetVelocity() * ImpactImpulseScale, GetActorLocation());
+			}
+		}
 
+		ReleaseProjectile();
+	}
+	else if (OtherActor != this && OtherComp != NULL)
+	{
+		StickAtImpact(Hit);
+	}
+}
+
+void AProjectile::SetShotLatency(float Latency)
+{
+	ShotLatency = Latency;
+	SetRewindSweepEnabled(HasAuthority() && !bIsCosmetic && !bIsInPool && Latency > 0.0f);
+}
+
+void AProjectile::SetRewindSweepEnabled(bool bEnabled)
+{
+	// Present archers are left to the sweep, the arrow still collides with everything else
+	const ECollisionResponse PawnResponse = bEnabled ? ECR_Ignore : GetClass()->GetDefaultObject<AProjectile>()->CollisionComp->GetCollisionResponseToChannel(ECC_Pawn);
+	CollisionComp->SetCollisionResponseToChannel(ECC_Pawn, PawnResponse);
+
+	LastSweepLocation = GetActorLocation();
+	SetActorTickEnabled(bEnabled);
+}
+
+void AProjectile::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	SweepRewoundArchers();
+}
+
+bool AProjectile::SweepRewoundArchers()
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ProjectileRewindSweep);
+
+	const FVector Start = LastSweepLocation;
+	const FVector End = GetActorLocation();
+	LastSweepLocation = End;
+
+	FHitResult Hit;
+	const float RewindTime = GetWorld()->GetTimeSeconds() - ShotLatency;
+	if (!UArcherLagCompensationComponent::SweepRewoundArchers(this, RewindTime, Start, End, CollisionComp->GetScaledSphereRadius(), RewindQueryRadius, GetOwner(), Hit))
+	{
+		return false;
+	}
+
+	AArcherCharacter* Victim = CastChecked<AArcherCharacter>(Hit.GetActor());
+	UE_LOG(LogArcher, Verbose, TEXT("%s hit %s %.0f ms in the past"), *GetName(), *Victim->GetName(), ShotLatency * 1000.0f);
+
+	// Damage and reactions are resolved with the frame's other hits on the same archer
+	if (UArcherImpactEventSubsystem* ImpactEvents = UArcherWorldSubsystem::Get<UArcherImpactEventSubsystem>(this))
+	{
+		ImpactEvents->QueueImpact(Victim, GetOwner(), GetImpactDamage(GetVelocity()), GetVelocity(), Hit);
+	}
+
+	SetRewindSweepEnabled(false);
+	if (!StickAtImpact(Hit))
+	{
+		StopAtImpact(Hit);
+	}
+	return true;
+}
+
+float AProjectile::GetImpactDamage(const FVector& ImpactVelocity) const
+{
+	const float InitialSpeed = ProjectileMovement->InitialSpeed;
+	return InitialSpeed > 0.0f ? Damage * FMath::Min(ImpactVelocity.Size() / InitialSpeed, 1.0f) : Damage;
+}
+
+void AProjectile::OnProjectileStop(const FHitResult& ImpactResult)
+{
+	// Resting or stuck arrow only needs to be seen, drop it from the broadphase and stop movement ticking
+	bIsDormant = true;
+	SetRewindSweepEnabled(false);
+	CollisionComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	ProjectileMovement->SetComponentTickEnabled(false);
+
+	// Nothing changes on a stuck arrow anymore, stop considering it for replication
+	if (GetIsReplicated() && HasAuthority())
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void AProjectile::OnAcquiredFromPool(const FVector& Location, const FRotator& Rotation)
+{
+	bIsInPool = false;
+	bIsDormant = false;
+	bIsCosmetic = false;
+	ShotLatency = 0.0f;
+	SetRewindSweepEnabled(false);
+
+	// Wake up before moving, the replication graph takes the arrow out of the grid cell it was stuck in
+	if (GetIsReplicated() && HasAuthority())
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	CollisionComp->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+
+	// StopSimulating() clears the updated component, so hook it back up before launching again
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = Rotation.Vector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->UpdateComponentVelocity();
+	ProjectileMovement->Activate(true);
+
+	if (UProjectileLifetimeSubsystem* LifetimeManager = UArcherWorldSubsystem::Get<UProjectileLifetimeSubsystem>(this))
+	{
+		LifetimeManager->RegisterProjectile(this);
+	}
+
+	UpdateInstancedRendering();
+}
+
+void AProjectile::OnReturnedToPool()
+{
+	bIsInPool = true;
+
+	if (UProjectileLifetimeSubsystem* LifetimeManager = UArcherWorldSubsystem::Get<UProjectileLifetimeSubsystem>(this))
+	{
+		LifetimeManager->UnregisterProjectile(this);
+	}
+
+	SetRewindSweepEnabled(false);
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+
+	UpdateInstancedRendering();
+
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+
+	if (GetIsReplicated() && HasAuthority())
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void AProjectile::StopAtImpact(const FHitResult& Hit)
+{
+	SetActorLocationAndRotation(Hit.Location, GetActorRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+
+	// Broadcasts OnProjectileStop, which makes the arrow dormant
+	ProjectileMovement->StopSimulating(Hit);
+}
+
+bool AProjectile::StickAtImpact(const FHitResult& Hit)
+{
+	if (ImpactMode != EArrowImpactMode::Stick || bIsInPool)
+	{
+		return false;
+	}
+
+	if (UStuckArrowSubsystem* StuckArrows = UArcherWorldSubsystem::Get<UStuckArrowSubsystem>(this))
+	{
+		StuckArrows->StickArrow(ProjectileMesh->GetStaticMesh(), ProjectileMesh->GetComponentTransform(), Hit);
+	}
+
+	// Proxy carries on in place of the arrow, collision and movement go back to the pool with the actor
+	ReleaseProjectile();
+	return true;
+}
+
+void AProjectile::UpdateInstancedRendering()
+{
+	// Dedicated server draws nothing
+	if (!bUseInstancedRendering || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	AArrowInstanceRenderer* Renderer = AArrowInstanceRenderer::Get(this);
+	if (Renderer == NULL)
+	{
+		return;
+	}
+
+	if (bIsInPool)
+	{
+		Renderer->UntrackProjectile(this);
+	}
+	else
+	{
+		Renderer->TrackProjectile(this);
+	}
+}
+
+void AProjectile::ReleaseProjectile()
+{
+	if (UProjectileLifetimeSubsystem* LifetimeManager = UArcherWorldSubsystem::Get<UProjectileLifetimeSubsystem>(this))
+	{
+		LifetimeManager->UnregisterProjectile(this);
+	}
+
+	if (OwningPool.IsValid())
+	{
+		OwningPool->Release(this);
+	}
+	else
+	{
 		Destroy();
 	}
 }
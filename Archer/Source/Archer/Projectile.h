@@ -6,6 +6,26 @@
 #include "GameFramework/Actor.h"
 #include "Projectile.generated.h"
 
+/** How arrows of a projectile class are moved while in flight */
+UENUM(BlueprintType)
+enum class EArrowSimulationMode : uint8
+{
+	/** Every arrow is an actor moved by its own UProjectileMovementComponent */
+	Actor,
+	/** Arrows are simulated together by AArrowSimulationManager, an actor is used only once the arrow lands */
+	Batched
+};
+
+/** What arrows of a projectile class do when they hit something that doesn't simulate physics */
+UENUM(BlueprintType)
+enum class EArrowImpactMode : uint8
+{
+	/** Arrow bounces off and stays an actor until it comes to rest and expires */
+	Bounce,
+	/** Arrow leaves a proxy stuck in the surface or bone it hit (UStuckArrowSubsystem) and goes back to the pool */
+	Stick
+};
+
 UCLASS()
 class ARCHER_API AProjectile : public AActor
 {
@@ -27,6 +47,13 @@ public:
 	// Sets default values for this actor's properties
 	AProjectile();
 
+protected:
+	virtual void BeginPlay() override;
+
+public:
+	/** Sweeps the arrow's moves against rewound archers while it flies for a lagging shooter, see SetShotLatency() */
+	virtual void Tick(float DeltaSeconds) override;
+
 	// set default offset for arrow grip point while aiming (to grip end of arrow)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Aim Grip Offset")
 	FVector ProjectileAimGripPointOffset;
@@ -35,14 +62,117 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Aim Grip Offset")
 		FRotator ProjectileAimPointRotationOffset;
 
+	/** How arrows of this class are simulated while in flight */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	EArrowSimulationMode SimulationMode;
+
+	/** What arrows of this class do when they hit static geometry or characters */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	EArrowImpactMode ImpactMode;
+
+	/** Quadratic air drag, deceleration is DragCoefficient * Speed^2. Used by batched simulation */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	float DragCoefficient;
+
+	/** Draw arrows of this class through shared instanced meshes (AArrowInstanceRenderer) instead of their own mesh component */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	bool bUseInstancedRendering;
+
+	/** Impulse applied to physics bodies is arrow velocity multiplied by this */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	float ImpactImpulseScale;
+
+	/** Health a full speed arrow takes from an archer, slower arrows do proportionally less */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	float Damage;
+
+	/** Archers this far from a lag compensated arrow's move are swept against, covers their size and how far they moved since the shot */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	float RewindQueryRadius;
+
+	/** Damage of an arrow of this class hitting at ImpactVelocity */
+	float GetImpactDamage(const FVector& ImpactVelocity) const;
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalIMpulse, const FHitResult& Hit);
 
+	/** called when projectile movement comes to rest, arrow goes dormant */
+	UFUNCTION()
+	void OnProjectileStop(const FHitResult& ImpactResult);
+
+	/**
+	 * Reset movement state and start flying, called by the arrow pool when the arrow is handed out
+	 * @param Location - world location to start from
+	 * @param Rotation - direction of flight
+	 */
+	void OnAcquiredFromPool(const FVector& Location, const FRotator& Rotation);
+
+	/** Hide arrow and stop every simulation, called by the arrow pool when the arrow comes back */
+	void OnReturnedToPool();
+
+	/** Stop flying at the impact point and go dormant, used when arrow was simulated elsewhere */
+	void StopAtImpact(const FHitResult& Hit);
+
+	/** Leave a stuck arrow proxy behind for Hit and release this arrow, returns false if the arrow doesn't stick */
+	bool StickAtImpact(const FHitResult& Hit);
+
+	/** Return arrow to its pool, or destroy it if it was not spawned by one */
+	void ReleaseProjectile();
+
+	void SetOwningPool(class UArrowPoolSubsystem* Pool) { OwningPool = Pool; }
+
+	/** Cosmetic arrows are client-side stand-ins for a shot the server simulates, they push nothing on impact */
+	void SetCosmetic(bool bCosmetic) { bIsCosmetic = bCosmetic; }
+	FORCEINLINE bool IsCosmetic() const { return bIsCosmetic; }
+
+	/**
+	 * Seconds the shooter's view lagged behind the server when it fired. On the server the arrow then passes through
+	 * present archers and hits them where they were that long ago instead, swept move by move in Tick()
+	 */
+	void SetShotLatency(float Latency);
+	FORCEINLINE float GetShotLatency() const { return ShotLatency; }
+
+	/** Returns true while arrow waits in the pool and is out of play */
+	FORCEINLINE bool IsInPool() const { return bIsInPool; }
+
+	/** Returns true once arrow came to rest and dropped collision and movement ticking */
+	FORCEINLINE bool IsDormant() const { return bIsDormant; }
+
+	/** Slot in the lifetime manager ring, INDEX_NONE when arrow is not tracked */
+	FORCEINLINE int32 GetLifetimeSlot() const { return LifetimeSlot; }
+	void SetLifetimeSlot(int32 Slot) { LifetimeSlot = Slot; }
+
 	/** Returns CollisionComp subobject **/
 	FORCEINLINE class USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
 	FORCEINLINE class UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }	
 	/** Returns ProjectileMesh subobject **/ 
 	FORCEINLINE class UStaticMeshComponent* GetProjectileMesh() const { return ProjectileMesh; }
+
+private:
+	/** Start or stop drawing arrow through AArrowInstanceRenderer, depending on whether it is in play */
+	void UpdateInstancedRendering();
+
+	/** Hit rewound archers on the way from LastSweepLocation to where the arrow is now, returns true if one was hit */
+	bool SweepRewoundArchers();
+
+	/** Turn lag compensated sweeping on or off, and with it collision against present archers */
+	void SetRewindSweepEnabled(bool bEnabled);
+
+	/** Pool this arrow goes back to, unset for arrows spawned directly */
+	TWeakObjectPtr<class UArrowPoolSubsystem> OwningPool;
+
+	bool bIsInPool;
+
+	bool bIsDormant;
+
+	bool bIsCosmetic;
+
+	float ShotLatency;
+
+	/** Where the last rewind sweep ended */
+	FVector LastSweepLocation;
+
+	int32 LifetimeSlot;
 };
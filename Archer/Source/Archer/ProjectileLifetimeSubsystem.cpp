@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileLifetimeSubsystem.h"
+#include "Archer.h"
+#include "Projectile.h"
+
+UProjectileLifetimeSubsystem::UProjectileLifetimeSubsystem()
+{
+	MaxLiveProjectiles = 256;
+	ProjectileLifetime = 30.0f;
+	MaxExpiriesPerFrame = 8;
+
+	Head = 0;
+	NumEntries = 0;
+	NumLive = 0;
+}
+
+void UProjectileLifetimeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Ring.SetNum(FMath::Max(MaxLiveProjectiles, 1));
+}
+
+void UProjectileLifetimeSubsystem::RegisterProjectile(AProjectile* Projectile)
+{
+	UWorld* const World = GetWorld();
+	if (Projectile == NULL || World == NULL || Projectile->GetWorld() != World)
+	{
+		return;
+	}
+
+	// Out of room: stale entries of arrows that left play early go first, only then the oldest arrow leaves play
+	if (NumEntries == Ring.Num() && NumLive < NumEntries)
+	{
+		CompactRing();
+	}
+	if (NumEntries == Ring.Num())
+	{
+		PopOldest();
+	}
+
+	const int32 Tail = (Head + NumEntries) % Ring.Num();
+	Ring[Tail].Projectile = Projectile;
+	Ring[Tail].ExpireTime = World->GetTimeSeconds() + ProjectileLifetime;
+	++NumEntries;
+	++NumLive;
+	SET_DWORD_STAT(STAT_LiveArrows, NumLive);
+
+	Projectile->SetLifetimeSlot(Tail);
+}
+
+void UProjectileLifetimeSubsystem::UnregisterProjectile(AProjectile* Projectile)
+{
+	const int32 Slot = Projectile != NULL ? Projectile->GetLifetimeSlot() : INDEX_NONE;
+	if (!Ring.IsValidIndex(Slot) || Ring[Slot].Projectile.Get() != Projectile)
+	{
+		return;
+	}
+
+	// Entry stays in the ring until it reaches the head, it is simply skipped then
+	Ring[Slot].Projectile.Reset();
+	Projectile->SetLifetimeSlot(INDEX_NONE);
+	--NumLive;
+	SET_DWORD_STAT(STAT_LiveArrows, NumLive);
+}
+
+void UProjectileLifetimeSubsystem::Tick(float DeltaTime)
+{
+	ARCHER_SCOPE_CYCLE_COUNTER(STAT_ArrowLifetimeTick);
+
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return;
+	}
+
+	const float Now = World->GetTimeSeconds();
+
+	// Ring is sorted by launch time and every arrow gets the same lifetime, so only the head can be due
+	int32 NumExpired = 0;
+	while (NumEntries > 0 && NumExpired < MaxExpiriesPerFrame)
+	{
+		const FLiveProjectile& Oldest = Ring[Head];
+		if (Oldest.Projectile.IsValid())
+		{
+			if (Oldest.ExpireTime > Now)
+			{
+				break;
+			}
+			++NumExpired;
+		}
+		PopOldest();
+	}
+}
+
+bool UProjectileLifetimeSubsystem::IsTickable() const
+{
+	return NumEntries > 0;
+}
+
+ETickableTickType UProjectileLifetimeSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UProjectileLifetimeSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileLifetimeSubsystem, STATGROUP_Tickables);
+}
+
+void UProjectileLifetimeSubsystem::ResetWorldState()
+{
+	for (FLiveProjectile& Entry : Ring)
+	{
+		Entry.Projectile.Reset();
+	}
+	Head = 0;
+	NumEntries = 0;
+	NumLive = 0;
+	SET_DWORD_STAT(STAT_LiveArrows, 0);
+}
+
+void UProjectileLifetimeSubsystem::PopOldest()
+{
+	FLiveProjectile& Oldest = Ring[Head];
+	AProjectile* Projectile = Oldest.Projectile.Get();
+	Oldest.Projectile.Reset();
+
+	Head = (Head + 1) % Ring.Num();
+	--NumEntries;
+
+	if (Projectile != NULL)
+	{
+		--NumLive;
+		SET_DWORD_STAT(STAT_LiveArrows, NumLive);
+		Projectile->SetLifetimeSlot(INDEX_NONE);
+		Projectile->ReleaseProjectile();
+	}
+}
+
+void UProjectileLifetimeSubsystem::CompactRing()
+{
+	int32 NumKept = 0;
+	for (int32 Index = 0; Index < NumEntries; ++Index)
+	{
+		const int32 Slot = (Head + Index) % Ring.Num();
+		AProjectile* Projectile = Ring[Slot].Projectile.Get();
+		if (Projectile == NULL)
+		{
+			continue;
+		}
+
+		// Kept entries only ever move toward Head, into slots already visited
+		const int32 NewSlot = (Head + NumKept) % Ring.Num();
+		if (NewSlot != Slot)
+		{
+			Ring[NewSlot] = Ring[Slot];
+			Ring[Slot].Projectile.Reset();
+			Projectile->SetLifetimeSlot(NewSlot);
+		}
+		++NumKept;
+	}
+
+	NumEntries = NumKept;
+	NumLive = NumKept;
+	SET_DWORD_STAT(STAT_LiveArrows, NumLive);
+}
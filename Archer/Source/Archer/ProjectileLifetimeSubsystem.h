@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "ProjectileLifetimeSubsystem.generated.h"
+
+class AProjectile;
+
+/**
+ * Central expiry for arrows in play. Keeps arrows in launch order in a fixed-size ring,
+ * evicts the oldest one when MaxLiveProjectiles is reached and expires at most MaxExpiriesPerFrame per frame.
+ */
+UCLASS(config = Game)
+class ARCHER_API UProjectileLifetimeSubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UProjectileLifetimeSubsystem();
+
+	/** Maximum number of arrows in play per world, launching more evicts the oldest one */
+	UPROPERTY(config, EditAnywhere, Category = "Projectile Lifetime")
+	int32 MaxLiveProjectiles;
+
+	/** Seconds an arrow stays in play after launch */
+	UPROPERTY(config, EditAnywhere, Category = "Projectile Lifetime")
+	float ProjectileLifetime;
+
+	/** Upper bound of arrows expired in one frame, the rest waits for the next frames */
+	UPROPERTY(config, EditAnywhere, Category = "Projectile Lifetime")
+	int32 MaxExpiriesPerFrame;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Start tracking launched arrow, may evict the oldest arrow in play */
+	void RegisterProjectile(AProjectile* Projectile);
+
+	/** Stop tracking arrow, called when arrow leaves play on its own (hit, back to pool) */
+	void UnregisterProjectile(AProjectile* Projectile);
+
+	/** Returns number of arrows currently tracked */
+	int32 GetNumLiveProjectiles() const { return NumLive; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	struct FLiveProjectile
+	{
+		TWeakObjectPtr<AProjectile> Projectile;
+		float ExpireTime;
+	};
+
+	/** Drop oldest ring entry, releasing its arrow if it is still in play */
+	void PopOldest();
+
+	/** Squeeze out stale entries, live arrows keep their launch order from Head on */
+	void CompactRing();
+
+	/** Launch ordered ring, Head is the oldest entry. Unregistered arrows leave a stale entry behind */
+	TArray<FLiveProjectile> Ring;
+	int32 Head;
+	int32 NumEntries;
+	int32 NumLive;
+};
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "StuckArrowSubsystem.h"
+#include "Archer.h"
+#include "ArrowInstanceRenderer.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/Character.h"
+
+UStuckArrowSubsystem::UStuckArrowSubsystem()
+{
+	MaxStuckArrows = 512;
+	StuckArrowLifetime = 60.0f;
+
+	Head = 0;
+	NumEntries = 0;
+}
+
+void UStuckArrowSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Ring.SetNum(FMath::Max(MaxStuckArrows, 1));
+}
+
+void UStuckArrowSubsystem::StickArrow(UStaticMesh* Mesh, const FTransform& MeshTransform, const FHitResult& Hit)
+{
+	UWorld* const World = GetWorld();
+	UPrimitiveComponent* HitComponent = Hit.GetComponent();
+	// Dedicated server shows nothing, the arrow is simply gone there
+	if (Mesh == NULL || World == NULL || HitComponent == NULL || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	FStuckArrow StuckArrow;
+	StuckArrow.InstanceId = INDEX_NONE;
+	StuckArrow.ExpireTime = World->GetTimeSeconds() + StuckArrowLifetime;
+
+	if (HitComponent->Mobility != EComponentMobility::Movable)
+	{
+		AArrowInstanceRenderer* Renderer = AArrowInstanceRenderer::Get(this);
+		StuckArrow.InstanceId = Renderer != NULL ? Renderer->AddInstance(Mesh, MeshTransform, true) : INDEX_NONE;
+		if (StuckArrow.InstanceId == INDEX_NONE)
+		{
+			return;
+		}
+	}
+	else
+	{
+		StuckArrow.Component = AttachArrow(Mesh, MeshTransform, Hit);
+		if (!StuckArrow.Component.IsValid())
+		{
+			return;
+		}
+	}
+
+	// Out of room: oldest arrow disappears to make space for the new one
+	if (NumEntries == Ring.Num())
+	{
+		PopOldest();
+	}
+
+	Ring[(Head + NumEntries) % Ring.Num()] = StuckArrow;
+	++NumEntries;
+	SET_DWORD_STAT(STAT_StuckArrows, NumEntries);
+}
+
+UStaticMeshComponent* UStuckArrowSubsystem::AttachArrow(UStaticMesh* Mesh, const FTransform& MeshTransform, const FHitResult& Hit) const
+{
+	USceneComponent* Parent = Hit.GetComponent();
+	FName BoneName = Hit.BoneName;
+
+	// Arrows stop at the capsule, follow the nearest bone so they move with the body
+	ACharacter* Character = Cast<ACharacter>(Hit.GetActor());
+	if (Character != NULL && BoneName == NAME_None && Character->GetMesh() != NULL)
+	{
+		Parent = Character->GetMesh();
+		BoneName = Character->GetMesh()->FindClosestBone(Hit.ImpactPoint);
+	}
+
+	AActor* Owner = Parent->GetOwner();
+	if (Owner == NULL)
+	{
+		return NULL;
+	}
+
+	UStaticMeshComponent* Component = NewObject<UStaticMeshComponent>(Owner, NAME_None, RF_Transient);
+	Component->SetStaticMesh(Mesh);
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Component->SetGenerateOverlapEvents(false);
+	Component->SetCanEverAffectNavigation(false);
+	Component->PrimaryComponentTick.bCanEverTick = false;
+	// Bounds of the parent are close enough and free to compute
+	Component->bUseAttachParentBound = true;
+	Component->SetWorldTransform(MeshTransform);
+	Component->AttachToComponent(Parent, FAttachmentTransformRules::KeepWorldTransform, BoneName);
+	Component->RegisterComponent();
+	return Component;
+}
+
+void UStuckArrowSubsystem::Tick(float DeltaTime)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return;
+	}
+
+	// Ring is sorted by stick time and every arrow gets the same lifetime, so only the head can be due
+	const float Now = World->GetTimeSeconds();
+	while (NumEntries > 0 && Ring[Head].ExpireTime <= Now)
+	{
+		PopOldest();
+	}
+}
+
+bool UStuckArrowSubsystem::IsTickable() const
+{
+	return NumEntries > 0;
+}
+
+ETickableTickType UStuckArrowSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UStuckArrowSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStuckArrowSubsystem, STATGROUP_Tickables);
+}
+
+void UStuckArrowSubsystem::ResetWorldState()
+{
+	// Instances and components go away with the world
+	for (FStuckArrow& StuckArrow : Ring)
+	{
+		StuckArrow.InstanceId = INDEX_NONE;
+		StuckArrow.Component.Reset();
+	}
+	Head = 0;
+	NumEntries = 0;
+	SET_DWORD_STAT(STAT_StuckArrows, 0);
+}
+
+void UStuckArrowSubsystem::PopOldest()
+{
+	FStuckArrow& Oldest = Ring[Head];
+	if (Oldest.InstanceId != INDEX_NONE)
+	{
+		if (AArrowInstanceRenderer* Renderer = AArrowInstanceRenderer::Get(this))
+		{
+			Renderer->RemoveInstance(Oldest.InstanceId);
+		}
+		Oldest.InstanceId = INDEX_NONE;
+	}
+	if (UStaticMeshComponent* Component = Oldest.Component.Get())
+	{
+		Component->DestroyComponent();
+	}
+	Oldest.Component.Reset();
+
+	Head = (Head + 1) % Ring.Num();
+	--NumEntries;
+	SET_DWORD_STAT(STAT_StuckArrows, NumEntries);
+}
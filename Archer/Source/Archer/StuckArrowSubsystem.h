@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "ArcherWorldSubsystem.h"
+#include "StuckArrowSubsystem.generated.h"
+
+class UStaticMesh;
+class UStaticMeshComponent;
+
+/**
+ * Keeps arrows that stuck in something on screen without their actors. Arrows in static geometry become static
+ * instances of AArrowInstanceRenderer, arrows in characters or other movable things become a bare mesh component
+ * attached to the hit bone. Neither ticks or collides, the arrow actor goes straight back to the pool.
+ * Proxies are kept in a fixed-size ring in stick order, the oldest is removed once the ring is full or its time is up.
+ */
+UCLASS(config = Game)
+class ARCHER_API UStuckArrowSubsystem : public UArcherWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UStuckArrowSubsystem();
+
+	/** Maximum number of stuck arrows shown per world, sticking more removes the oldest one */
+	UPROPERTY(config, EditAnywhere, Category = "Stuck Arrows")
+	int32 MaxStuckArrows;
+
+	/** Seconds a stuck arrow stays visible */
+	UPROPERTY(config, EditAnywhere, Category = "Stuck Arrows")
+	float StuckArrowLifetime;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/**
+	 * Leave a proxy of an arrow behind where it hit
+	 * @param Mesh - arrow mesh
+	 * @param MeshTransform - world transform of the arrow mesh at impact
+	 * @param Hit - what the arrow hit, the proxy follows the hit component and bone if they can move
+	 */
+	void StickArrow(UStaticMesh* Mesh, const FTransform& MeshTransform, const FHitResult& Hit);
+
+	/** Returns number of stuck arrows currently shown */
+	int32 GetNumStuckArrows() const { return NumEntries; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	virtual void ResetWorldState() override;
+
+private:
+	struct FStuckArrow
+	{
+		/** Static instance in the arrow instance renderer, INDEX_NONE for attached arrows */
+		int32 InstanceId;
+		/** Mesh component of an arrow attached to something movable */
+		TWeakObjectPtr<UStaticMeshComponent> Component;
+		float ExpireTime;
+	};
+
+	/** Attach a bare mesh component to the hit component or the closest bone of a hit character */
+	UStaticMeshComponent* AttachArrow(UStaticMesh* Mesh, const FTransform& MeshTransform, const FHitResult& Hit) const;
+
+	/** Remove oldest arrow from the ring and the world */
+	void PopOldest();
+
+	TArray<FStuckArrow> Ring;
+	int32 Head;
+	int32 NumEntries;
+};